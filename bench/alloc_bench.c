@@ -0,0 +1,137 @@
+/**
+ * @file alloc_bench.c
+ * @brief Counts heap allocations per compilation, with and without an arena
+ * @author joaomrpimentel
+ * @version 1.2
+ *
+ * Linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc so every
+ * allocation made by the compiler objects goes through the counters below.
+ *
+ * Usage: alloc_bench <input.jshl> [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "jshl_compiler.h"
+#include "note_list.h"
+#include "parser.h"
+#include "arena.h"
+#include "diagnostics.h"
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+static size_t alloc_count = 0;
+static size_t alloc_bytes = 0;
+
+void* __wrap_malloc(size_t size) {
+    alloc_count++;
+    alloc_bytes += size;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    alloc_count++;
+    alloc_bytes += count * size;
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    alloc_count++;
+    alloc_bytes += size;
+    return __real_realloc(ptr, size);
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Compiles a source with every structure on the heap
+ * @return Number of notes, or 0 on failure
+ */
+static size_t compile_heap(char* code) {
+    NoteList list;
+    Program program;
+    cli_note_list_init(&list);
+    cli_program_init(&program);
+    if (parse_jshl_program(code, &program) != 0) exit(1);
+    if (program_execute(&program, &list) != 0) exit(1);
+    size_t notes = list.size;
+    program_free(&program);
+    note_list_free(&list);
+    return notes;
+}
+
+/**
+ * @brief Compiles a source into an arena, releasing the previous compilation
+ * @return Number of notes, or 0 on failure
+ */
+static size_t compile_arena(char* code, Arena* arena) {
+    NoteList list;
+    Program program;
+    arena_reset(arena);
+    if (note_list_init_arena(&list, arena) != 0) exit(1);
+    if (program_init_arena(&program, arena) != 0) exit(1);
+    if (parse_jshl_program(code, &program) != 0) exit(1);
+    if (program_execute(&program, &list) != 0) exit(1);
+    return list.size;
+}
+
+static void report(const char* mode, int iterations, size_t count, size_t bytes, double seconds) {
+    printf("%-8s %16.1f %16.1f %14.2f\n", mode,
+           (double)count / iterations, (double)bytes / iterations,
+           seconds * 1e6 / iterations);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <input.jshl> [iterations]\n", argv[0]);
+        return 1;
+    }
+    int iterations = argc > 2 ? atoi(argv[2]) : 1000;
+    if (iterations < 1) iterations = 1;
+
+    FILE* fp = fopen(argv[1], "r");
+    if (!fp) {
+        fprintf(stderr, "Error: Cannot read file '%s'\n", argv[1]);
+        return 1;
+    }
+    fseek(fp, 0, SEEK_END);
+    long file_size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char* code = (char*)malloc(file_size + 1);
+    if (!code || fread(code, 1, file_size, fp) != (size_t)file_size) {
+        fprintf(stderr, "Error: Cannot read file '%s'\n", argv[1]);
+        fclose(fp);
+        return 1;
+    }
+    code[file_size] = '\0';
+    fclose(fp);
+
+    printf("Compiling '%s' (%zu notes) %d times\n\n", argv[1], compile_heap(code), iterations);
+    printf("%-8s %16s %16s %14s\n", "mode", "allocs/compile", "bytes/compile", "us/compile");
+
+    alloc_count = alloc_bytes = 0;
+    double start = now_seconds();
+    for (int i = 0; i < iterations; i++) compile_heap(code);
+    report("malloc", iterations, alloc_count, alloc_bytes, now_seconds() - start);
+
+    // The first compilation sizes the arena; later ones reuse its chunks
+    Arena arena;
+    arena_init(&arena, 0);
+    compile_arena(code, &arena);
+
+    alloc_count = alloc_bytes = 0;
+    start = now_seconds();
+    for (int i = 0; i < iterations; i++) compile_arena(code, &arena);
+    report("arena", iterations, alloc_count, alloc_bytes, now_seconds() - start);
+
+    arena_free(&arena);
+    free(code);
+    return 0;
+}
@@ -0,0 +1,747 @@
+/**
+ * @file jshl_bench.c
+ * @brief Throughput benchmarks of the parser, synthesizer and encoders
+ * @author joaomrpimentel
+ * @version 1.3
+ *
+ * Every benchmark runs a fixed workload a number of times after a few
+ * untimed warmup runs and reports percentiles of the per-run wall time
+ * together with the throughput at the median, so results can be tracked
+ * across releases.
+ *
+ * Usage: jshl_bench [--format text|json|csv] [--reps N] [--warmup N]
+ *                   [--filter TEXT] [--scale F] [--tmp-dir DIR]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "jshl_compiler.h"
+#include "note_list.h"
+#include "note_table.h"
+#include "parser.h"
+#include "arena.h"
+#include "note_index.h"
+#include "synth.h"
+#include "audio_writer.h"
+#include "diagnostics.h"
+
+/** Largest supported --reps */
+#define BENCH_MAX_REPS 1000
+
+/** Samples handed to a writer per call, as in the compiler's pipeline */
+#define BENCH_WRITE_CHUNK 65536
+
+/**
+ * @brief Report layout
+ */
+typedef enum {
+    BENCH_TEXT,
+    BENCH_JSON,
+    BENCH_CSV
+} BenchFormat;
+
+/**
+ * @brief Options shared by every benchmark
+ */
+typedef struct {
+    BenchFormat format;
+    int reps;               /**< Timed runs per benchmark */
+    int warmup;             /**< Untimed runs before them */
+    const char* filter;     /**< Substring a benchmark name must contain (NULL = all) */
+    double scale;           /**< Workload size factor */
+    const char* tmp_dir;    /**< Directory for encoder output files */
+    int reported;           /**< Benchmarks printed so far */
+} BenchConfig;
+
+/**
+ * @brief Workload of one benchmark
+ */
+typedef struct {
+    const char* name;
+    int (*run)(void* ctx);  /**< One repetition; returns 0 on success */
+    void* ctx;
+    double work;            /**< Items processed per repetition */
+    const char* work_unit;  /**< Item name ("bytes", "samples", ...) */
+    const char* rate_unit;  /**< Unit of the reported throughput */
+    double rate_scale;      /**< Items per rate_unit */
+} Bench;
+
+/**
+ * @brief Timing summary of one benchmark
+ */
+typedef struct {
+    double min;
+    double mean;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+} BenchStats;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Returns a nearest-rank percentile of sorted values
+ */
+static double percentile(const double* sorted, int count, double p) {
+    int rank = (int)ceil(p / 100.0 * count);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    return sorted[rank - 1];
+}
+
+static void bench_stats(double* times, int count, BenchStats* stats) {
+    qsort(times, count, sizeof(double), compare_doubles);
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) sum += times[i];
+    stats->min = times[0];
+    stats->mean = sum / count;
+    stats->p50 = percentile(times, count, 50.0);
+    stats->p90 = percentile(times, count, 90.0);
+    stats->p99 = percentile(times, count, 99.0);
+    stats->max = times[count - 1];
+}
+
+static void bench_report(BenchConfig* config, const Bench* bench, const BenchStats* stats) {
+    double rate = bench->work / stats->p50 / bench->rate_scale;
+    double best = bench->work / stats->min / bench->rate_scale;
+
+    switch (config->format) {
+        case BENCH_JSON:
+            printf("%s\n    {\"name\": \"%s\", \"work\": %.0f, \"work_unit\": \"%s\", "
+                   "\"reps\": %d, \"warmup\": %d,\n"
+                   "     \"seconds\": {\"min\": %.9f, \"mean\": %.9f, \"p50\": %.9f, "
+                   "\"p90\": %.9f, \"p99\": %.9f, \"max\": %.9f},\n"
+                   "     \"throughput\": {\"unit\": \"%s\", \"p50\": %.6g, \"best\": %.6g}}",
+                   config->reported ? "," : "", bench->name, bench->work, bench->work_unit,
+                   config->reps, config->warmup, stats->min, stats->mean, stats->p50,
+                   stats->p90, stats->p99, stats->max, bench->rate_unit, rate, best);
+            break;
+        case BENCH_CSV:
+            printf("%s,%.0f,%s,%d,%d,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f,%s,%.6g,%.6g\n",
+                   bench->name, bench->work, bench->work_unit, config->reps, config->warmup,
+                   stats->min, stats->mean, stats->p50, stats->p90, stats->p99, stats->max,
+                   bench->rate_unit, rate, best);
+            break;
+        default:
+            printf("%-28s %10.3f %10.3f %10.3f %12.2f %s\n", bench->name,
+                   stats->p50 * 1e3, stats->p90 * 1e3, stats->max * 1e3, rate, bench->rate_unit);
+            break;
+    }
+    fflush(stdout);
+    config->reported++;
+}
+
+/**
+ * @brief Runs and reports one benchmark unless the filter excludes it
+ * @return 0 on success (or skipped), -1 if a repetition failed
+ */
+static int bench_run(BenchConfig* config, const Bench* bench) {
+    if (config->filter && !strstr(bench->name, config->filter)) return 0;
+
+    double times[BENCH_MAX_REPS];
+    for (int i = 0; i < config->warmup; i++) {
+        if (bench->run(bench->ctx) != 0) goto failed;
+    }
+    for (int i = 0; i < config->reps; i++) {
+        double start = now_seconds();
+        if (bench->run(bench->ctx) != 0) goto failed;
+        times[i] = now_seconds() - start;
+    }
+
+    BenchStats stats;
+    bench_stats(times, config->reps, &stats);
+    bench_report(config, bench, &stats);
+    return 0;
+
+failed:
+    fprintf(stderr, "Error: Benchmark '%s' failed\n", bench->name);
+    return -1;
+}
+
+/* ------------------------------------------------------------------------
+ * Parser
+ * ------------------------------------------------------------------------ */
+
+/**
+ * @brief Growable text buffer for generated sources
+ */
+typedef struct {
+    char* data;
+    size_t size;
+    size_t capacity;
+} TextBuffer;
+
+static void text_append(TextBuffer* text, const char* line) {
+    size_t length = strlen(line);
+    if (text->size + length + 1 > text->capacity) {
+        size_t capacity = text->capacity ? text->capacity * 2 : 4096;
+        while (capacity < text->size + length + 1) capacity *= 2;
+        char* grown = (char*)realloc(text->data, capacity);
+        if (!grown) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            exit(1);
+        }
+        text->data = grown;
+        text->capacity = capacity;
+    }
+    memcpy(text->data + text->size, line, length + 1);
+    text->size += length;
+}
+
+static const char* const bench_notes[] = {
+    "C3", "D#3", "F3", "G3", "Bb3", "C4", "E4", "F#4", "A4", "Db5", "E5", "G5", "B5"
+};
+#define BENCH_NOTE_COUNT (sizeof(bench_notes) / sizeof(bench_notes[0]))
+
+/**
+ * @brief Generates a long flat song exercising every statement
+ */
+static void generate_flat_source(TextBuffer* text, int notes) {
+    static const char* const waves[] = { "SINE", "SQUARE", "SAWTOOTH", "TRIANGLE" };
+    char line[64];
+
+    for (int i = 0; i < notes; i++) {
+        if (i % 64 == 0) {
+            snprintf(line, sizeof(line), "WAVE %s\nENVELOPE 0.01 0.05 0.7 0.%d\n",
+                     waves[(i / 64) % 4], 1 + (i / 64) % 9);
+            text_append(text, line);
+        }
+        if (i % 16 == 8) text_append(text, "PAUSE 0.125\n");
+        if (i % 32 == 0) text_append(text, i % 64 ? "SLIDE 0.02\n" : "SLIDE 0.0\n");
+        snprintf(line, sizeof(line), "%s 0.%03d\n",
+                 bench_notes[i % BENCH_NOTE_COUNT], 100 + (i * 37) % 400);
+        text_append(text, line);
+    }
+}
+
+/**
+ * @brief Generates short nested loops expanding to many notes
+ */
+static void generate_loop_source(TextBuffer* text, int blocks) {
+    char line[64];
+
+    text_append(text, "WAVE SINE\nENVELOPE 0.01 0.05 0.7 0.2\n");
+    for (int b = 0; b < blocks; b++) {
+        snprintf(line, sizeof(line), "LOOP %d {\n", 2 + b % 3);
+        text_append(text, line);
+        text_append(text, "  LOOP 4 {\n");
+        for (int n = 0; n < 4; n++) {
+            snprintf(line, sizeof(line), "    %s 0.1\n", bench_notes[(b + n) % BENCH_NOTE_COUNT]);
+            text_append(text, line);
+        }
+        text_append(text, "  }\n  PAUSE 0.1\n}\n");
+    }
+}
+
+typedef struct {
+    TextBuffer source;
+    Arena arena;
+    bool record_loops;      /**< Record loop spans as --loop-clips does */
+} ParseBench;
+
+static int parse_bench_run(void* ctx) {
+    ParseBench* bench = (ParseBench*)ctx;
+    NoteList list;
+    Program program;
+    LoopList loops;
+
+    arena_reset(&bench->arena);
+    loop_list_init(&loops);
+    if (note_list_init_arena(&list, &bench->arena) != 0 ||
+        program_init_arena(&program, &bench->arena) != 0 ||
+        parse_jshl_source(bench->source.data, bench->source.size, &program) != 0 ||
+        program_execute_loops(&program, &list, bench->record_loops ? &loops : NULL) != 0) {
+        loop_list_free(&loops);
+        return -1;
+    }
+    loop_list_free(&loops);
+    return list.size > 0 ? 0 : -1;
+}
+
+static int bench_parser(BenchConfig* config) {
+    ParseBench flat = { { NULL, 0, 0 }, { 0 }, false };
+    ParseBench loops = { { NULL, 0, 0 }, { 0 }, true };
+    generate_flat_source(&flat.source, (int)(200000 * config->scale) + 1);
+    generate_loop_source(&loops.source, (int)(20000 * config->scale) + 1);
+    arena_init(&flat.arena, 0);
+    arena_init(&loops.arena, 0);
+
+    Bench benches[] = {
+        { "parse/flat", parse_bench_run, &flat, (double)flat.source.size,
+          "bytes", "MB/s", 1e6 },
+        { "parse/loops", parse_bench_run, &loops, (double)loops.source.size,
+          "bytes", "MB/s", 1e6 }
+    };
+
+    int status = 0;
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        if (bench_run(config, &benches[i]) != 0) status = -1;
+    }
+
+    arena_free(&flat.arena);
+    arena_free(&loops.arena);
+    free(flat.source.data);
+    free(loops.source.data);
+    return status;
+}
+
+/* ------------------------------------------------------------------------
+ * Note lookup
+ * ------------------------------------------------------------------------ */
+
+/** Names looked up per repetition */
+#define LOOKUP_COUNT 1000000
+
+typedef struct {
+    const char* names[BENCH_NOTE_COUNT * 3];
+    int lookups;
+    volatile float sink;    /**< Keeps the lookups from being optimized away */
+} LookupBench;
+
+static int lookup_bench_run(void* ctx) {
+    LookupBench* bench = (LookupBench*)ctx;
+    size_t count = sizeof(bench->names) / sizeof(bench->names[0]);
+    float sum = 0.0f;
+
+    for (int i = 0; i < bench->lookups; i++) sum += get_note_freq(bench->names[i % count]);
+    bench->sink = sum;
+    return 0;
+}
+
+static int bench_note_lookup(BenchConfig* config) {
+    static char names[BENCH_NOTE_COUNT * 3][8];
+    LookupBench lookup;
+
+    // Every note of the list in three octaves
+    for (size_t i = 0; i < BENCH_NOTE_COUNT * 3; i++) {
+        const char* note = bench_notes[i % BENCH_NOTE_COUNT];
+        size_t length = strlen(note);
+        memcpy(names[i], note, length - 1);
+        names[i][length - 1] = (char)('3' + i / BENCH_NOTE_COUNT);
+        names[i][length] = '\0';
+        lookup.names[i] = names[i];
+    }
+    lookup.lookups = (int)(LOOKUP_COUNT * config->scale) + 1;
+
+    Bench bench = { "note_freq", lookup_bench_run, &lookup, (double)lookup.lookups,
+                    "lookups", "Mlookups/s", 1e6 };
+    return bench_run(config, &bench);
+}
+
+/* ------------------------------------------------------------------------
+ * Synthesizer
+ * ------------------------------------------------------------------------ */
+
+typedef struct {
+    NoteList list;
+    long samples;           /**< Song length, set by the first run */
+} RenderBench;
+
+static int render_bench_run(void* ctx) {
+    RenderBench* bench = (RenderBench*)ctx;
+    long total = 0;
+    float* buffer = render_audio(&bench->list, &total);
+    free(buffer);
+    return total == bench->samples ? 0 : -1;
+}
+
+/**
+ * @brief Builds a song where 'voices' notes sound at any time
+ * @param list Output note list
+ * @param wave Waveform of every note
+ * @param voices Polyphony
+ * @param seconds Song length
+ */
+static void build_polyphonic_song(NoteList* list, WaveType wave, int voices, double seconds) {
+    const float duration = 0.5f;
+    SynthState state = { wave, { 0.01f, 0.05f, 0.7f, 0.05f }, 0.0f, 0.0f };
+    int count = (int)(seconds / duration * voices);
+    if (count < 1) count = 1;
+
+    cli_note_list_init(list);
+    for (int i = 0; i < count; i++) {
+        NoteEvent note;
+        note.freq = 110.0f * (float)(1 + i % 8);
+        note.duration = duration;
+        note.start_time = (float)i * duration / (float)voices;
+        note.state = state;
+        note.state.last_freq = note.freq;
+        cli_note_list_add(list, note);
+    }
+}
+
+static int bench_render(BenchConfig* config) {
+    static const struct { WaveType wave; const char* name; } waves[] = {
+        { WAVE_SINE, "sine" }, { WAVE_SQUARE, "square" },
+        { WAVE_SAWTOOTH, "sawtooth" }, { WAVE_TRIANGLE, "triangle" }
+    };
+    static const int polyphony[] = { 1, 4, 16 };
+    int status = 0;
+
+    for (size_t w = 0; w < sizeof(waves) / sizeof(waves[0]); w++) {
+        for (size_t p = 0; p < sizeof(polyphony) / sizeof(polyphony[0]); p++) {
+            char name[64];
+            RenderBench render;
+            snprintf(name, sizeof(name), "render/%s/poly%d", waves[w].name, polyphony[p]);
+            if (config->filter && !strstr(name, config->filter)) continue;
+
+            build_polyphonic_song(&render.list, waves[w].wave, polyphony[p], 10.0 * config->scale);
+            free(render_audio(&render.list, &render.samples));
+
+            Bench bench = { name, render_bench_run, &render, (double)render.samples,
+                            "samples", "Msamples/s", 1e6 };
+            if (bench_run(config, &bench) != 0) status = -1;
+            note_list_free(&render.list);
+        }
+    }
+    return status;
+}
+
+/* ------------------------------------------------------------------------
+ * Note index
+ * ------------------------------------------------------------------------ */
+
+/** Notes of the indexed song at scale 1 */
+#define INDEX_NOTES 1000000
+
+/** Window queries per repetition */
+#define INDEX_QUERIES 100000
+
+/** Query window in samples, as read by the streaming renderer */
+#define INDEX_WINDOW 4096
+
+typedef struct {
+    long* starts;
+    long* ends;
+    size_t count;
+    long length;            /**< Song length in samples */
+    long max_length;        /**< Longest interval, for the scan baseline */
+    long* windows;          /**< Query starts */
+    NoteIndex index;
+    size_t hits;            /**< Notes found by the last run */
+} IndexBench;
+
+static void count_hit(size_t note, void* context) {
+    (void)note;
+    (*(size_t*)context)++;
+}
+
+static int index_build_run(void* ctx) {
+    IndexBench* bench = (IndexBench*)ctx;
+    NoteIndex index;
+    if (note_index_build(&index, bench->starts, bench->ends, bench->count) != 0) return -1;
+    note_index_free(&index);
+    return 0;
+}
+
+static int index_query_run(void* ctx) {
+    IndexBench* bench = (IndexBench*)ctx;
+    size_t hits = 0;
+    for (int q = 0; q < INDEX_QUERIES; q++) {
+        long from = bench->windows[q];
+        note_index_query(&bench->index, from, from + INDEX_WINDOW, count_hit, &hits);
+    }
+    bench->hits = hits;
+    return 0;
+}
+
+/**
+ * @brief Baseline: binary search bounded by the longest note, then a walk
+ *
+ * This is how a renderer finds sounding notes without an index; every
+ * query pays for all notes started within one longest-note length.
+ */
+static int index_scan_run(void* ctx) {
+    IndexBench* bench = (IndexBench*)ctx;
+    size_t hits = 0;
+    for (int q = 0; q < INDEX_QUERIES; q++) {
+        long from = bench->windows[q];
+        long to = from + INDEX_WINDOW;
+        size_t lo = 0;
+        size_t hi = bench->count;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (bench->starts[mid] < from - bench->max_length) lo = mid + 1;
+            else hi = mid;
+        }
+        for (size_t i = lo; i < bench->count && bench->starts[i] < to; i++) {
+            if (bench->ends[i] > from) hits++;
+        }
+    }
+    return hits == bench->hits ? 0 : -1;
+}
+
+/**
+ * @brief Generates the indexed song and its query windows
+ * @param index Bench with allocated arrays
+ * @param pad_seconds Release tail of the pads
+ *
+ * A note every 50 ms lasting 0.1 to 0.4 s; every 500th note is a pad
+ * ringing for pad_seconds.
+ */
+static void build_index_song(IndexBench* index, long pad_seconds) {
+    uint32_t seed = 12345;
+    index->max_length = 0;
+    for (size_t i = 0; i < index->count; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        long length = (i % 500 == 0) ? pad_seconds * SAMPLE_RATE
+                                     : (long)(SAMPLE_RATE / 10) * (1 + (long)(seed >> 30));
+        index->starts[i] = (long)i * (SAMPLE_RATE / 20);
+        index->ends[i] = index->starts[i] + length;
+        if (length > index->max_length) index->max_length = length;
+    }
+    index->length = index->ends[index->count - 1];
+    for (int q = 0; q < INDEX_QUERIES; q++) {
+        seed = seed * 1664525u + 1013904223u;
+        index->windows[q] = (long)((double)seed / 4294967296.0 * index->length);
+    }
+}
+
+static int bench_note_index(BenchConfig* config) {
+    // The scan baseline grows with the longest pad, the index does not
+    static const long pad_seconds[] = { 30, 300 };
+    IndexBench index;
+    index.count = (size_t)(INDEX_NOTES * config->scale) + 1;
+    index.starts = (long*)malloc(index.count * sizeof(long));
+    index.ends = (long*)malloc(index.count * sizeof(long));
+    index.windows = (long*)malloc(INDEX_QUERIES * sizeof(long));
+    if (!index.starts || !index.ends || !index.windows) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        free(index.starts);
+        free(index.ends);
+        free(index.windows);
+        return -1;
+    }
+
+    int status = 0;
+    for (size_t p = 0; p < sizeof(pad_seconds) / sizeof(pad_seconds[0]); p++) {
+        char build_name[64];
+        char query_name[64];
+        char scan_name[64];
+        size_t thousands = index.count / 1000;
+        snprintf(build_name, sizeof(build_name), "index/build/%zuk", thousands);
+        snprintf(query_name, sizeof(query_name), "index/query/%zuk/pad%lds", thousands,
+                 pad_seconds[p]);
+        snprintf(scan_name, sizeof(scan_name), "index/scan/%zuk/pad%lds", thousands,
+                 pad_seconds[p]);
+
+        build_index_song(&index, pad_seconds[p]);
+        if (note_index_build(&index.index, index.starts, index.ends, index.count) != 0) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            status = -1;
+            break;
+        }
+
+        Bench build = { build_name, index_build_run, &index, (double)index.count,
+                        "notes", "Mnotes/s", 1e6 };
+        Bench query = { query_name, index_query_run, &index, INDEX_QUERIES,
+                        "queries", "Mqueries/s", 1e6 };
+        Bench scan = { scan_name, index_scan_run, &index, INDEX_QUERIES,
+                       "queries", "Mqueries/s", 1e6 };
+
+        // The scan checks its hit count against the query's
+        index_query_run(&index);
+        if (p == 0 && bench_run(config, &build) != 0) status = -1;
+        if (bench_run(config, &query) != 0) status = -1;
+        if (bench_run(config, &scan) != 0) status = -1;
+        note_index_free(&index.index);
+    }
+
+    free(index.starts);
+    free(index.ends);
+    free(index.windows);
+    return status;
+}
+
+/* ------------------------------------------------------------------------
+ * Writers
+ * ------------------------------------------------------------------------ */
+
+typedef struct {
+    OutputFormat format;
+    AudioWriterOptions options;
+    char path[4096];
+    const float* samples;
+    long count;
+} WriterBench;
+
+static int writer_bench_run(void* ctx) {
+    WriterBench* bench = (WriterBench*)ctx;
+    AudioWriter writer;
+
+    if (audio_writer_open_with_options(&writer, bench->format, bench->path,
+                                       SAMPLE_RATE, &bench->options) != 0) {
+        return -1;
+    }
+    int status = 0;
+    for (long done = 0; done < bench->count && status == 0; done += BENCH_WRITE_CHUNK) {
+        long frames = bench->count - done < BENCH_WRITE_CHUNK ? bench->count - done
+                                                             : BENCH_WRITE_CHUNK;
+        status = audio_writer_write(&writer, bench->samples + done, frames);
+    }
+    if (audio_writer_close(&writer) != 0) status = -1;
+    unlink(bench->path);
+    return status;
+}
+
+static int bench_writers(BenchConfig* config) {
+    static const struct {
+        const char* name;
+        OutputFormat format;
+        PcmFormat pcm;
+        bool dither;
+    } writers[] = {
+        { "write/wav", FORMAT_WAV, PCM_FLOAT32, false },
+        { "write/wav16-dither", FORMAT_WAV, PCM_INT16, true },
+        { "write/wav24", FORMAT_WAV, PCM_INT24, false },
+        { "write/raw", FORMAT_RAW, PCM_FLOAT32, false },
+        { "write/flac", FORMAT_FLAC, PCM_FLOAT32, false },
+        { "write/mp3", FORMAT_MP3, PCM_FLOAT32, false }
+    };
+
+    long count = (long)(SAMPLE_RATE * 30 * config->scale) + 1;
+    float* samples = (float*)malloc(count * sizeof(float));
+    if (!samples) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return -1;
+    }
+
+    // Two detuned tones: compressible but not trivially so
+    for (long i = 0; i < count; i++) {
+        double t = (double)i / SAMPLE_RATE;
+        samples[i] = (float)(0.4 * sin(2.0 * PI * 440.0 * t) + 0.2 * sin(2.0 * PI * 659.3 * t));
+    }
+
+    int status = 0;
+    for (size_t i = 0; i < sizeof(writers) / sizeof(writers[0]); i++) {
+        WriterBench writer;
+        writer.format = writers[i].format;
+        audio_writer_options_init(&writer.options);
+        writer.options.pcm_format = writers[i].pcm;
+        writer.options.dither = writers[i].dither;
+        writer.samples = samples;
+        writer.count = count;
+        snprintf(writer.path, sizeof(writer.path), "%s/jshl_bench_%ld.%s", config->tmp_dir,
+                 (long)getpid(), audio_format_extension(writers[i].format));
+
+        // Throughput is measured against the float input
+        Bench bench = { writers[i].name, writer_bench_run, &writer,
+                        (double)count * sizeof(float), "bytes", "MB/s", 1e6 };
+        if (bench_run(config, &bench) != 0) status = -1;
+    }
+
+    free(samples);
+    return status;
+}
+
+/* ------------------------------------------------------------------------
+ * Driver
+ * ------------------------------------------------------------------------ */
+
+static void print_usage(const char* program_name) {
+    fprintf(stderr, "Usage: %s [--format text|json|csv] [--reps N] [--warmup N]\n"
+                    "       %*s [--filter TEXT] [--scale F] [--tmp-dir DIR]\n",
+            program_name, (int)strlen(program_name), "");
+}
+
+static bool parse_args(int argc, char* argv[], BenchConfig* config) {
+    const char* tmp = getenv("TMPDIR");
+    config->format = BENCH_TEXT;
+    config->reps = 10;
+    config->warmup = 2;
+    config->filter = NULL;
+    config->scale = 1.0;
+    config->tmp_dir = tmp && *tmp ? tmp : "/tmp";
+    config->reported = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!value) {
+            print_usage(argv[0]);
+            return false;
+        }
+        i++;
+
+        if (strcmp(arg, "--format") == 0) {
+            if (strcmp(value, "json") == 0) config->format = BENCH_JSON;
+            else if (strcmp(value, "csv") == 0) config->format = BENCH_CSV;
+            else if (strcmp(value, "text") == 0) config->format = BENCH_TEXT;
+            else {
+                fprintf(stderr, "Error: Unknown format '%s'\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--reps") == 0) {
+            config->reps = atoi(value);
+            if (config->reps < 1 || config->reps > BENCH_MAX_REPS) {
+                fprintf(stderr, "Error: Repetitions must be between 1 and %d\n", BENCH_MAX_REPS);
+                return false;
+            }
+        } else if (strcmp(arg, "--warmup") == 0) {
+            config->warmup = atoi(value);
+            if (config->warmup < 0) config->warmup = 0;
+        } else if (strcmp(arg, "--filter") == 0) {
+            config->filter = value;
+        } else if (strcmp(arg, "--scale") == 0) {
+            config->scale = atof(value);
+            if (!(config->scale > 0.0 && config->scale <= 100.0)) {
+                fprintf(stderr, "Error: Scale must be in (0, 100]\n");
+                return false;
+            }
+        } else if (strcmp(arg, "--tmp-dir") == 0) {
+            config->tmp_dir = value;
+        } else {
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    if (!parse_args(argc, argv, &config)) return 1;
+
+    switch (config.format) {
+        case BENCH_JSON:
+            printf("{\"sample_rate\": %d, \"scale\": %g, \"benchmarks\": [", SAMPLE_RATE,
+                   config.scale);
+            break;
+        case BENCH_CSV:
+            printf("name,work,work_unit,reps,warmup,min_s,mean_s,p50_s,p90_s,p99_s,max_s,"
+                   "rate_unit,rate_p50,rate_best\n");
+            break;
+        default:
+            printf("%d repetitions after %d warmup run(s), scale %g\n\n",
+                   config.reps, config.warmup, config.scale);
+            printf("%-28s %10s %10s %10s %12s\n", "benchmark", "p50 ms", "p90 ms", "max ms",
+                   "rate (p50)");
+            break;
+    }
+
+    int status = 0;
+    if (bench_parser(&config) != 0) status = 1;
+    if (bench_note_lookup(&config) != 0) status = 1;
+    if (bench_render(&config) != 0) status = 1;
+    if (bench_note_index(&config) != 0) status = 1;
+    if (bench_writers(&config) != 0) status = 1;
+
+    if (config.format == BENCH_JSON) printf("\n]}\n");
+    return status;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file audio_writer.h
+ * @brief Format-independent incremental audio export interface
+ * @author joaomrpimentel
+ * @version 1.2
+ */
+
+#ifndef AUDIO_WRITER_H
+#define AUDIO_WRITER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "jshl_compiler.h"
+#include "pcm_writer.h"
+
+/**
+ * @brief Open output file of any supported format
+ */
+typedef struct {
+    OutputFormat format;    /**< Format selecting the backend */
+    void* handle;           /**< WavWriter, RawWriter, FlacWriter or Mp3Writer */
+    bool pcm24;             /**< Accepts audio_writer_write_pcm24 */
+} AudioWriter;
+
+/**
+ * @brief Encoder options
+ */
+typedef struct {
+    int threads;            /**< Encoder threads where supported (FLAC); 1 = serial, < 1 = all CPUs */
+    PcmFormat pcm_format;   /**< Sample encoding of WAV and RAW output */
+    bool dither;            /**< Dither WAV and RAW integer output */
+} AudioWriterOptions;
+
+/**
+ * @brief Fills options with defaults (serial encoding, 32-bit float PCM)
+ * @param options Options to initialize
+ */
+void audio_writer_options_init(AudioWriterOptions* options);
+
+/**
+ * @brief Opens an output file for incremental writing
+ * @param writer Writer to initialize
+ * @param format Output format
+ * @param filename Output file path
+ * @param sample_rate Sample rate in Hz
+ * @return 0 on success, -1 on error
+ */
+int audio_writer_open(AudioWriter* writer, OutputFormat format,
+                      const char* filename, int sample_rate);
+
+/**
+ * @brief Opens an output file with explicit encoder options
+ * @param writer Writer to initialize
+ * @param format Output format
+ * @param filename Output file path
+ * @param sample_rate Sample rate in Hz
+ * @param options Encoder options (NULL for defaults)
+ * @return 0 on success, -1 on error
+ */
+int audio_writer_open_with_options(AudioWriter* writer, OutputFormat format,
+                                   const char* filename, int sample_rate,
+                                   const AudioWriterOptions* options);
+
+/**
+ * @brief Appends samples to the output
+ * @param writer Open writer
+ * @param samples Float PCM samples in range [-1.0, 1.0]
+ * @param count Number of samples
+ * @return 0 on success, -1 on error
+ */
+int audio_writer_write(AudioWriter* writer, const float* samples, long count);
+
+/**
+ * @brief Tells whether a writer is encoded from 24-bit integer samples
+ * @param writer Open writer
+ * @return true if audio_writer_write_pcm24 avoids a conversion for it
+ *         (FLAC, and undithered 24-bit WAV or RAW)
+ */
+bool audio_writer_uses_pcm24(const AudioWriter* writer);
+
+/**
+ * @brief Appends samples that were already converted to 24-bit integers
+ * @param writer Open writer (audio_writer_uses_pcm24 must be true)
+ * @param pcm Samples scaled by INT24_SCALE (see dsp_kernels()->float_to_int)
+ * @param count Number of samples
+ * @return 0 on success, -1 on error
+ */
+int audio_writer_write_pcm24(AudioWriter* writer, const int32_t* pcm, long count);
+
+/**
+ * @brief Finalizes and closes the output
+ * @param writer Writer to close
+ * @return 0 on success, -1 on error
+ */
+int audio_writer_close(AudioWriter* writer);
+
+/**
+ * @brief Returns the conventional file extension of a format
+ * @param format Output format
+ * @return Extension without the dot ("wav", "raw", "flac", "mp3")
+ */
+const char* audio_format_extension(OutputFormat format);
+
+/**
+ * @brief Returns the version of the library encoding a format
+ * @param format Output format
+ * @return libFLAC or LAME version, or "" for formats written by jshl itself
+ */
+const char* audio_format_encoder_version(OutputFormat format);
+
+#endif /* AUDIO_WRITER_H */
@@ -0,0 +1,87 @@
+/**
+ * @file dsp.h
+ * @brief Vectorized DSP kernels with runtime CPU dispatch
+ * @author joaomrpimentel
+ * @version 1.1
+ */
+
+#ifndef DSP_H
+#define DSP_H
+
+#include <stdint.h>
+#include "jshl_compiler.h"
+
+/** Full-scale value of a 24-bit sample (2^23 - 1) */
+#define INT24_SCALE 8388607.0f
+
+/** Full-scale value of a 16-bit sample (2^15 - 1) */
+#define INT16_SCALE 32767.0f
+
+/**
+ * @brief Table of kernel implementations for one instruction set
+ *
+ * All implementations perform the same floating point operations in the
+ * same order as the scalar reference, so output is bit-identical no
+ * matter which table is selected.
+ */
+typedef struct {
+    const char* name;   /**< Instruction set name ("scalar", "sse2", "avx2") */
+
+    /**
+     * @brief Fills out[i] with the waveform at phase (phase + i * step)
+     * @see osc_fill
+     */
+    void (*osc_fill)(WaveType wave, float phase, float step, float* out, int count);
+
+    /**
+     * @brief Mixes an enveloped block: out[i] += src[i] * (level + (index + i) * delta) * gain
+     * @param index Position of src[0] within the envelope ramp
+     */
+    void (*mix_ramp)(float* out, const float* src, int count,
+                     float level, float delta, int index, float gain);
+
+    /**
+     * @brief Hard-clips a buffer in place to [-1.0, 1.0]
+     */
+    void (*clip)(float* buffer, long count);
+
+    /**
+     * @brief Converts float samples to integers: (int32_t)(clamp(in[i]) * scale)
+     * @param scale Full-scale integer value (e.g. 8388607 for 24-bit)
+     */
+    void (*float_to_int)(const float* in, int32_t* out, long count, float scale);
+
+    /**
+     * @brief Converts float samples to 16-bit PCM: round-to-nearest(clamp(in[i]) * INT16_SCALE)
+     */
+    void (*float_to_int16)(const float* in, int16_t* out, long count);
+
+    /**
+     * @brief Converts float samples to 24-bit PCM: round-to-nearest(clamp(in[i]) * INT24_SCALE)
+     *
+     * Used for dithered output, whose +-1 LSB noise float_to_int would
+     * truncate away around zero. FLAC and undithered PCM keep float_to_int.
+     */
+    void (*float_to_int24)(const float* in, int32_t* out, long count);
+} DspKernels;
+
+/**
+ * @brief Returns the kernels for the best instruction set of this CPU
+ * @return Kernel table (never NULL)
+ *
+ * Selection happens once per process. Set JSHL_SIMD=scalar, sse2 or avx2
+ * to force a specific implementation (unsupported choices fall back to
+ * the best available one).
+ */
+const DspKernels* dsp_kernels(void);
+
+/** @brief Portable C implementation */
+extern const DspKernels dsp_scalar_kernels;
+
+/** @brief SSE2 implementation (all members NULL when not built for x86) */
+extern const DspKernels dsp_sse2_kernels;
+
+/** @brief AVX2 implementation (all members NULL when not built for x86) */
+extern const DspKernels dsp_avx2_kernels;
+
+#endif /* DSP_H */
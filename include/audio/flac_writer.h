@@ -2,12 +2,19 @@
  * @file flac_writer.h
  * @brief FLAC file export interface using libFLAC
  * @author joaomrpimentel
- * @version 1.0
+ * @version 1.4
  */
 
 #ifndef FLAC_WRITER_H
 #define FLAC_WRITER_H
 
+#include <stdint.h>
+
+/**
+ * @brief Opaque incremental FLAC writer
+ */
+typedef struct FlacWriter FlacWriter;
+
 /**
  * @brief Exports audio buffer to FLAC file
  * @param filename Output file path
@@ -27,4 +34,61 @@
  */
 int write_flac_file(const char* filename, float* buffer, long sample_count, int sample_rate);
 
-#endif /* FLAC_WRITER_H */
\ No newline at end of file
+/**
+ * @brief Creates a FLAC file for incremental encoding
+ * @param filename Output file path
+ * @param sample_rate Sample rate in Hz
+ * @return Writer handle, or NULL on error
+ *
+ * STREAMINFO (length and MD5) is rewritten by libFLAC when the writer
+ * is closed, so the length does not need to be known up front.
+ */
+FlacWriter* flac_writer_open(const char* filename, int sample_rate);
+
+/**
+ * @brief Creates a FLAC file encoded on several threads
+ * @param filename Output file path
+ * @param sample_rate Sample rate in Hz
+ * @param threads Encoder threads (1 = serial, < 1 = all CPUs)
+ * @return Writer handle, or NULL on error
+ *
+ * Uses libFLAC's own frame-parallel encoder when it is available (FLAC
+ * API version 14, libFLAC 1.5, built with threading), otherwise encodes
+ * serially. The output is the same stream either way.
+ */
+FlacWriter* flac_writer_open_threads(const char* filename, int sample_rate, int threads);
+
+/**
+ * @brief Converts and encodes samples
+ * @param writer Open writer
+ * @param samples Float PCM samples in range [-1.0, 1.0]
+ * @param count Number of samples
+ * @return 0 on success, -1 on encoder error
+ */
+int flac_writer_write(FlacWriter* writer, const float* samples, long count);
+
+/**
+ * @brief Encodes samples already converted to 24-bit integers
+ * @param writer Open writer
+ * @param pcm Samples scaled by INT24_SCALE, as float_to_int produces them
+ * @param count Number of samples
+ * @return 0 on success, -1 on encoder error
+ *
+ * Lets several outputs share one conversion of the same audio.
+ */
+int flac_writer_write_pcm24(FlacWriter* writer, const int32_t* pcm, long count);
+
+/**
+ * @brief Finishes the stream, closes the file and frees the writer
+ * @param writer Writer to close (NULL is ignored)
+ * @return 0 on success, -1 on error
+ */
+int flac_writer_close(FlacWriter* writer);
+
+/**
+ * @brief Returns the version of the linked libFLAC
+ * @return Version string, e.g. "1.4.3"
+ */
+const char* flac_writer_version(void);
+
+#endif /* FLAC_WRITER_H */
@@ -0,0 +1,79 @@
+/**
+ * @file loop_clip.h
+ * @brief Pre-rendered LOOP iterations mixed at each repetition's offset
+ * @author joaomrpimentel
+ * @version 1.1
+ */
+
+#ifndef LOOP_CLIP_H
+#define LOOP_CLIP_H
+
+#include "jshl_compiler.h"
+#include "voice.h"
+
+/**
+ * @brief One loop iteration rendered once, relative to its first note-on
+ */
+typedef struct {
+    float* samples;     /**< Unclipped mix of the iteration's voices */
+    long length;        /**< Samples including the longest release tail */
+} LoopClip;
+
+/**
+ * @brief Loop iteration that is played back from a clip
+ */
+typedef struct {
+    size_t first_note;  /**< First note of the iteration in the note list */
+    size_t note_count;  /**< Notes replaced by the clip */
+    long anchor;        /**< Absolute note-on sample of the first note */
+    size_t clip;        /**< Index into LoopClipSet.clips */
+} ClipInstance;
+
+/**
+ * @brief Clips for a whole song and the iterations using them
+ */
+typedef struct {
+    LoopClip* clips;
+    size_t clip_count;
+    ClipInstance* instances;    /**< Ordered by first_note, never overlapping */
+    size_t instance_count;
+} LoopClipSet;
+
+/**
+ * @brief Finds time-invariant loop iterations and renders them once
+ * @param set Output clip set
+ * @param list Expanded note list (ordered by start time)
+ * @param loops Loop spans recorded by program_execute_loops
+ * @param phase Phase policy used for the voices
+ * @param sample_rate Sample rate in Hz
+ * @param draft Render the clips with draft oscillators (see voice_use_draft_oscillator)
+ * @return 0 on success, -1 on allocation failure
+ *
+ * An iteration uses a clip when every voice matches an earlier iteration
+ * (see voice_same_shape) at the same offset from the first note-on.
+ * Iterations whose notes land on different samples get separate clips,
+ * and clips used only once are not rendered. Outer loops are preferred
+ * over the loops nested in them.
+ * With VOICE_PHASE_GLOBAL iterations rarely match, since each note
+ * starts at a different oscillator phase.
+ */
+int loop_clips_build(LoopClipSet* set, const NoteList* list, const LoopList* loops,
+                     VoicePhase phase, int sample_rate, bool draft);
+
+/**
+ * @brief Adds a clip into an output window
+ * @param clip Rendered clip
+ * @param anchor Absolute sample where the clip starts
+ * @param out Output buffer holding absolute samples [from, to)
+ * @param from First absolute sample of the window
+ * @param to One past the last absolute sample of the window
+ */
+void loop_clip_mix(const LoopClip* clip, long anchor, float* out, long from, long to);
+
+/**
+ * @brief Frees all memory associated with a clip set
+ * @param set Clip set to deallocate
+ */
+void loop_clips_free(LoopClipSet* set);
+
+#endif /* LOOP_CLIP_H */
@@ -2,12 +2,17 @@
  * @file mp3_writer.h
  * @brief MP3 file export interface using LAME encoder
  * @author joaomrpimentel
- * @version 1.0
+ * @version 1.3
  */
 
 #ifndef MP3_WRITER_H
 #define MP3_WRITER_H
 
+/**
+ * @brief Opaque incremental MP3 writer
+ */
+typedef struct Mp3Writer Mp3Writer;
+
 /**
  * @brief Exports audio buffer to MP3 file
  * @param filename Output file path
@@ -22,8 +27,45 @@
  * - Channels: 1 (mono)
  * - Requires: libmp3lame
  * 
+ * Encodes through an Mp3Writer, so memory use does not depend on the
+ * track length.
+ *
  * @note Requires LAME MP3 encoder library installed
  */
 int write_mp3_file(const char* filename, float* buffer, long sample_count, int sample_rate);
 
+/**
+ * @brief Creates an MP3 file for incremental encoding
+ * @param filename Output file path
+ * @param sample_rate Sample rate in Hz
+ * @return Writer handle, or NULL on error
+ */
+Mp3Writer* mp3_writer_open(const char* filename, int sample_rate);
+
+/**
+ * @brief Encodes samples and writes the produced MP3 frames
+ * @param writer Open writer
+ * @param samples Float PCM samples in range [-1.0, 1.0]
+ * @param count Number of samples
+ * @return 0 on success, -1 on error
+ *
+ * Samples are fed to LAME in runs of a few 1152-sample frames and each
+ * run's output is written at once from a fixed buffer inside the
+ * writer, so memory use is constant whatever count and track length.
+ */
+int mp3_writer_write(Mp3Writer* writer, const float* samples, long count);
+
+/**
+ * @brief Flushes the encoder, closes the file and frees the writer
+ * @param writer Writer to close (NULL is ignored)
+ * @return 0 on success, -1 on error
+ */
+int mp3_writer_close(Mp3Writer* writer);
+
+/**
+ * @brief Returns the version of the linked LAME library
+ * @return Version string, e.g. "3.100"
+ */
+const char* mp3_writer_version(void);
+
 #endif /* MP3_WRITER_H */
\ No newline at end of file
@@ -0,0 +1,98 @@
+/**
+ * @file note_cache.h
+ * @brief LRU cache of rendered notes keyed by voice shape
+ * @author joaomrpimentel
+ * @version 1.0
+ */
+
+#ifndef NOTE_CACHE_H
+#define NOTE_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "voice.h"
+
+/**
+ * @brief Enveloped samples of one voice shape
+ *
+ * Sample k holds exactly what voice_render() adds to note-relative
+ * sample k, so mixing a clip is bit-identical to rendering the voice.
+ */
+typedef struct NoteClip {
+    Voice shape;                    /**< Voice with start = 0 */
+    float* samples;                 /**< shape.length samples */
+    uint64_t hash;
+    int pins;                       /**< Active users; pinned clips are never evicted */
+    struct NoteClip* bucket_next;
+    struct NoteClip* lru_prev;      /**< Towards most recently used */
+    struct NoteClip* lru_next;      /**< Towards least recently used */
+} NoteClip;
+
+/**
+ * @brief Cache counters
+ */
+typedef struct {
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    size_t bypassed;    /**< Notes too large for the cache, rendered directly */
+} NoteCacheStats;
+
+/**
+ * @brief Note clip cache
+ *
+ * Not thread-safe: clips are acquired and released by a single thread,
+ * while any number of threads may mix pinned clips.
+ */
+typedef struct {
+    NoteClip** buckets;
+    size_t bucket_count;            /**< Power of two */
+    size_t entries;
+    NoteClip* lru_head;             /**< Most recently used */
+    NoteClip* lru_tail;             /**< Least recently used */
+    size_t bytes;                   /**< Sample memory held by clips */
+    size_t max_bytes;               /**< Memory cap (pinned clips may exceed it) */
+    NoteCacheStats stats;
+} NoteCache;
+
+/**
+ * @brief Creates an empty cache
+ * @param max_bytes Maximum sample memory
+ * @return New cache, or NULL on allocation failure
+ */
+NoteCache* note_cache_create(size_t max_bytes);
+
+/**
+ * @brief Finds or renders the clip of a voice and pins it
+ * @param cache Cache to search
+ * @param voice Voice to look up (its start sample is ignored)
+ * @return Pinned clip, or NULL if the voice should be rendered directly
+ *
+ * Least recently used unpinned clips are evicted to stay under the cap.
+ */
+NoteClip* note_cache_acquire(NoteCache* cache, const Voice* voice);
+
+/**
+ * @brief Unpins a clip returned by note_cache_acquire
+ * @param cache Owning cache
+ * @param clip Clip to release
+ */
+void note_cache_release(NoteCache* cache, NoteClip* clip);
+
+/**
+ * @brief Adds a clip into an output window
+ * @param clip Rendered clip
+ * @param start Absolute note-on sample
+ * @param out Output buffer holding absolute samples [from, to)
+ * @param from First absolute sample of the window
+ * @param to One past the last absolute sample of the window
+ */
+void note_clip_mix(const NoteClip* clip, long start, float* out, long from, long to);
+
+/**
+ * @brief Frees a cache and all its clips (NULL is ignored)
+ * @param cache Cache to destroy
+ */
+void note_cache_destroy(NoteCache* cache);
+
+#endif /* NOTE_CACHE_H */
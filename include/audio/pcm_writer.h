@@ -0,0 +1,117 @@
+/**
+ * @file pcm_writer.h
+ * @brief Buffered PCM sample output shared by the WAV and RAW writers
+ * @author joaomrpimentel
+ * @version 1.2
+ */
+
+#ifndef PCM_WRITER_H
+#define PCM_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Sample encoding of uncompressed output
+ */
+typedef enum {
+    PCM_FLOAT32,    /**< 32-bit IEEE float, samples as rendered */
+    PCM_INT16,      /**< 16-bit signed integer, rounded (optionally dithered) */
+    PCM_INT24       /**< 24-bit signed integer, packed little-endian (truncated, or dithered and rounded) */
+} PcmFormat;
+
+/**
+ * @brief Opaque PCM writer
+ */
+typedef struct PcmWriter PcmWriter;
+
+/**
+ * @brief Returns the size of one sample
+ * @param format Sample encoding
+ * @return Bytes per sample (4, 2 or 3)
+ */
+int pcm_format_bytes(PcmFormat format);
+
+/**
+ * @brief Parses a bit depth
+ * @param bits 16, 24 or 32 (32 meaning float)
+ * @param format Output encoding
+ * @return true if bits is supported
+ */
+bool pcm_format_from_bits(int bits, PcmFormat* format);
+
+/**
+ * @brief Creates a file for sample output
+ * @param filename Output file path
+ * @param format Sample encoding
+ * @param dither Add triangular dither (one LSB of the target depth) before
+ *        integer quantization, 16- or 24-bit; ignored for PCM_FLOAT32
+ * @param header Bytes written before the samples (may be NULL if header_size is 0)
+ * @param header_size Header length
+ * @return Writer handle, or NULL on error
+ *
+ * Samples are converted straight into a large page-aligned buffer that
+ * is written with one write() call whenever it fills, so the file sees a
+ * few large sequential writes however small the chunks handed in are.
+ * The header can be rewritten at close time with pcm_writer_patch.
+ */
+PcmWriter* pcm_writer_open(const char* filename, PcmFormat format, bool dither,
+                           const void* header, size_t header_size);
+
+/**
+ * @brief Converts and appends float samples
+ * @param writer Open writer
+ * @param samples Float PCM samples in range [-1.0, 1.0]
+ * @param count Number of samples
+ * @return 0 on success, -1 on write error
+ */
+int pcm_writer_write(PcmWriter* writer, const float* samples, long count);
+
+/**
+ * @brief Appends samples already converted to 24-bit integers
+ * @param writer Open PCM_INT24 writer without dither
+ * @param pcm Samples scaled by INT24_SCALE (see dsp_kernels()->float_to_int)
+ * @param count Number of samples
+ * @return 0 on success, -1 on write error
+ *
+ * Produces the same bytes as pcm_writer_write on the original floats.
+ */
+int pcm_writer_write_pcm24(PcmWriter* writer, const int32_t* pcm, long count);
+
+/**
+ * @brief Appends raw bytes after the samples written so far
+ * @param writer Open writer
+ * @param data Bytes to append (e.g. a pad byte or trailing chunk)
+ * @param size Number of bytes
+ * @return 0 on success, -1 on write error
+ */
+int pcm_writer_append(PcmWriter* writer, const void* data, size_t size);
+
+/**
+ * @brief Returns the number of samples written so far
+ * @param writer Open writer
+ * @return Sample count
+ */
+long pcm_writer_samples(const PcmWriter* writer);
+
+/**
+ * @brief Overwrites bytes of the header after the samples were written
+ * @param writer Open writer
+ * @param offset Byte offset in the file (within the header)
+ * @param data Replacement bytes
+ * @param size Number of bytes
+ * @return 0 on success, -1 on error
+ *
+ * Uses pwrite, so the sample stream is not disturbed.
+ */
+int pcm_writer_patch(PcmWriter* writer, size_t offset, const void* data, size_t size);
+
+/**
+ * @brief Flushes buffered samples, closes the file and frees the writer
+ * @param writer Writer to close (NULL is ignored)
+ * @return 0 on success, -1 if any write failed
+ */
+int pcm_writer_close(PcmWriter* writer);
+
+#endif /* PCM_WRITER_H */
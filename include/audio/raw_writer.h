@@ -2,12 +2,21 @@
  * @file raw_writer.h
  * @brief Raw PCM file export interface
  * @author joaomrpimentel
- * @version 1.0
+ * @version 1.2
  */
 
 #ifndef RAW_WRITER_H
 #define RAW_WRITER_H
 
+#include <stdbool.h>
+#include <stdint.h>
+#include "pcm_writer.h"
+
+/**
+ * @brief Opaque incremental raw PCM writer
+ */
+typedef struct RawWriter RawWriter;
+
 /**
  * @brief Exports audio buffer to raw PCM file
  * @param filename Output file path
@@ -24,4 +33,45 @@
  */
 void write_raw_file(const char* filename, float* buffer, long sample_count);
 
-#endif /* RAW_WRITER_H */
\ No newline at end of file
+/**
+ * @brief Creates a raw PCM file for incremental writing
+ * @param filename Output file path
+ * @return Writer handle, or NULL on error
+ */
+RawWriter* raw_writer_open(const char* filename);
+
+/**
+ * @brief Creates a raw PCM file with a chosen sample encoding
+ * @param filename Output file path
+ * @param format Sample encoding (integers are signed little-endian)
+ * @param dither Add triangular dither before integer quantization
+ * @return Writer handle, or NULL on error
+ */
+RawWriter* raw_writer_open_format(const char* filename, PcmFormat format, bool dither);
+
+/**
+ * @brief Appends samples to the file
+ * @param writer Open writer
+ * @param samples Float PCM samples in range [-1.0, 1.0]
+ * @param count Number of samples
+ * @return 0 on success, -1 on write error
+ */
+int raw_writer_write(RawWriter* writer, const float* samples, long count);
+
+/**
+ * @brief Appends samples already converted to 24-bit integers
+ * @param writer Writer opened with PCM_INT24 and no dither
+ * @param pcm Samples scaled by INT24_SCALE
+ * @param count Number of samples
+ * @return 0 on success, -1 on write error
+ */
+int raw_writer_write_pcm24(RawWriter* writer, const int32_t* pcm, long count);
+
+/**
+ * @brief Closes the file and frees the writer
+ * @param writer Writer to close (NULL is ignored)
+ * @return 0 on success, -1 if any write failed
+ */
+int raw_writer_close(RawWriter* writer);
+
+#endif /* RAW_WRITER_H */
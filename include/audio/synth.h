@@ -2,26 +2,60 @@
  * @file synth.h
  * @brief Audio synthesis engine interface
  * @author joaomrpimentel
- * @version 1.0
+ * @version 1.3
  */
 
 #ifndef SYNTH_H
 #define SYNTH_H
 
+#include <stdbool.h>
 #include "jshl_compiler.h"
+#include "voice.h"
+#include "loop_clip.h"
+#include "note_cache.h"
+#include "thread_pool.h"
+#include "note_index.h"
+
+/**
+ * @brief Rendering options
+ */
+typedef struct {
+    int threads;            /**< Worker threads; 1 renders serially, < 1 uses all CPUs */
+    VoicePhase phase;       /**< Oscillator phase at note-on */
+    const LoopList* loops;  /**< Loop spans to render once as clips (NULL = off) */
+    NoteCache* note_cache;  /**< Rendered-note cache shared by renders (NULL = off) */
+    int sample_rate;        /**< Output sample rate in Hz */
+    bool draft;             /**< Cheaper oscillators for previews (see voice_use_draft_oscillator) */
+} SynthOptions;
+
+/**
+ * @brief Fills options with defaults (serial rendering at SAMPLE_RATE, song-clock
+ *        phase, no clips)
+ * @param options Options to initialize
+ */
+void synth_options_init(SynthOptions* options);
+
+/**
+ * @brief Computes the rendered length of a song
+ * @param list Note list
+ * @param sample_rate Sample rate in Hz
+ * @return Total samples: last note, its release and a 1 second tail
+ */
+long synth_song_length(const NoteList* list, int sample_rate);
 
 /**
  * @brief Renders note list to PCM audio buffer
  * @param list Input note list containing all events
  * @param total_samples Output parameter for buffer length
- * @return Pointer to float audio buffer (caller must free), or NULL if empty
+ * @return Pointer to float audio buffer (caller must free), or NULL if the
+ *         list is empty or allocation failed (total_samples is then 0)
  * 
  * Rendering pipeline per note:
- * 1. ADSR envelope calculation (attack/decay/sustain/release phases)
- * 2. Frequency slide interpolation (if configured)
- * 3. Oscillator generation
+ * 1. ADSR envelope split into linear segments (see voice_init)
+ * 2. Frequency slide as a linear glide of the phase increment
+ * 3. Phase-accumulator oscillator (phase aligned to the song clock at note-on)
  * 4. Gain compensation by waveform type
- * 5. Additive mixing into output buffer
+ * 5. Additive mixing into output buffer, one block of samples at a time
  * 6. Hard clipping to [-1.0, 1.0] range
  * 
  * @note Buffer is zero-initialized for clean mixing
@@ -29,4 +63,150 @@
  */
 float* render_audio(NoteList* list, long* total_samples);
 
+/**
+ * @brief Renders note list to PCM audio buffer with explicit options
+ * @param list Input note list containing all events
+ * @param total_samples Output parameter for buffer length
+ * @param options Rendering options (NULL for defaults)
+ * @return Pointer to float audio buffer (caller must free), or NULL if the
+ *         list is empty or allocation failed (total_samples is then 0)
+ *
+ * With more than one thread the timeline is split into fixed-size tiles.
+ * Each tile mixes the notes overlapping it (release tails included) in
+ * list order and clips its own samples, so the output is bit-identical
+ * to the serial render.
+ *
+ * With loop clips enabled, matching loop iterations are rendered once and
+ * mixed at each repetition's offset (see loop_clips_build). The summation
+ * order then differs from per-note mixing, so results may differ from a
+ * render without clips in the last bits.
+ *
+ * The note cache does not change the output: each clip holds exactly
+ * the samples its voice would add. It only pays off with
+ * VOICE_PHASE_NOTE, where repeated notes share one shape.
+ */
+float* render_audio_with_options(NoteList* list, long* total_samples,
+                                 const SynthOptions* options);
+
+/**
+ * @brief Voice currently sounding in a stream
+ */
+typedef struct {
+    Voice voice;
+    NoteClip* clip;         /**< Cached samples, or NULL to render the voice */
+} ActiveVoice;
+
+/**
+ * @brief Clip instance currently sounding in a stream
+ */
+typedef struct {
+    const LoopClip* clip;
+    long anchor;            /**< Absolute start sample of the clip */
+} ActiveClip;
+
+/**
+ * @brief Incremental renderer producing the song in time order
+ *
+ * Only the voices sounding in the current window are kept, so memory is
+ * bounded by the chunk size and the polyphony instead of the song length.
+ */
+typedef struct {
+    const NoteList* list;   /**< Source notes (must outlive the stream) */
+    long total_samples;     /**< Length of the whole render */
+    long position;          /**< Next sample to be produced */
+    size_t next_note;       /**< First note not yet activated */
+    bool sorted;            /**< Notes ordered by start time */
+    VoicePhase phase;       /**< Oscillator phase at note-on */
+    int sample_rate;        /**< Output sample rate in Hz */
+    bool draft;             /**< Voices use draft oscillators */
+    ActiveVoice* active;    /**< Sounding voices, in list order */
+    size_t active_count;
+    size_t active_capacity;
+    LoopClipSet clips;      /**< Pre-rendered loop iterations */
+    size_t next_instance;   /**< First clip instance not yet activated */
+    ActiveClip* active_clips; /**< Sounding clips, in list order */
+    size_t active_clip_count;
+    size_t active_clip_capacity;
+    NoteCache* note_cache;  /**< Rendered-note cache (NULL = off) */
+    int threads;            /**< Threads sharing each chunk */
+    ThreadPool* pool;       /**< Worker pool when threads > 1 */
+    NoteIndex index;        /**< Note ranges for seeking (valid if indexed) */
+    bool indexed;
+} SynthStream;
+
+/**
+ * @brief Prepares a streaming render
+ * @param stream Stream to initialize
+ * @param list Note list to render (ordered by start time for bounded memory)
+ * @param options Rendering options (NULL for defaults)
+ * @return 0 on success, -1 on error
+ */
+int synth_stream_init(SynthStream* stream, const NoteList* list, const SynthOptions* options);
+
+/**
+ * @brief Preallocates the active sets for reads of bounded size
+ * @param stream Initialized stream
+ * @param max_frames Largest 'frames' that will be passed to synth_stream_read
+ * @return 0 on success, -1 on allocation failure
+ *
+ * Sizes the active voice and clip arrays for the busiest window of the
+ * song and builds the seek index, so that later reads of at most
+ * max_frames samples and seeks never allocate (as long as no note cache
+ * is used). Meant for callers on a real-time thread; costs O(n log n) in
+ * the number of notes.
+ */
+int synth_stream_reserve(SynthStream* stream, long max_frames);
+
+/**
+ * @brief Renders the next chunk of the song
+ * @param stream Active stream
+ * @param out Output buffer with room for 'frames' samples
+ * @param frames Maximum number of samples to produce
+ * @return Samples written (0 at end of song), or -1 on error
+ *
+ * Chunks are clipped to [-1.0, 1.0] and, concatenated, are bit-identical
+ * to the buffer returned by render_audio().
+ */
+long synth_stream_read(SynthStream* stream, float* out, long frames);
+
+/**
+ * @brief Restarts a stream at the first sample
+ * @param stream Active stream
+ *
+ * Keeps every allocation, so the song can be played again without
+ * allocating.
+ */
+void synth_stream_rewind(SynthStream* stream);
+
+/**
+ * @brief Moves a stream to an arbitrary sample
+ * @param stream Active stream
+ * @param sample Next sample to produce (clamped to the song length)
+ * @return 0 on success, -1 on allocation failure
+ *
+ * Rebuilds the active set from the notes and clip instances still
+ * sounding at 'sample', release tails included; voices derive their
+ * envelope, glide and phase from absolute time, so the following reads
+ * are bit-identical to the same span of a render from the start. For
+ * songs ordered by start time the sounding notes come from the note
+ * index in O(log n + k), independent of the seek position and of how
+ * long other notes ring. The first seek builds the index; after that
+ * (or after synth_stream_reserve) seeking only allocates if the active
+ * set outgrows its capacity.
+ */
+int synth_stream_seek(SynthStream* stream, long sample);
+
+/**
+ * @brief Builds the stream's note index if it does not exist yet
+ * @param stream Initialized stream
+ * @return 0 on success, -1 on allocation failure
+ */
+int synth_stream_index(SynthStream* stream);
+
+/**
+ * @brief Releases the resources of a stream
+ * @param stream Stream to free
+ */
+void synth_stream_free(SynthStream* stream);
+
 #endif /* SYNTH_H */
\ No newline at end of file
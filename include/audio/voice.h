@@ -0,0 +1,122 @@
+/**
+ * @file voice.h
+ * @brief Per-note voice: precomputed envelope segments and block rendering
+ * @author joaomrpimentel
+ * @version 1.2
+ */
+
+#ifndef VOICE_H
+#define VOICE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "jshl_compiler.h"
+
+/** Samples rendered per inner block */
+#define VOICE_BLOCK_SIZE 256
+
+/** Attack, decay, sustain and release */
+#define VOICE_MAX_SEGMENTS 4
+
+/**
+ * @brief Oscillator phase at note-on
+ */
+typedef enum {
+    VOICE_PHASE_GLOBAL,     /**< Continue a free-running oscillator on the song clock */
+    VOICE_PHASE_NOTE        /**< Restart at phase 0, so a note sounds the same at any time */
+} VoicePhase;
+
+/**
+ * @brief Linear piece of the ADSR envelope
+ *
+ * Offsets are relative to the note-on sample. The level of sample k in
+ * the segment is level + (k - offset) * delta.
+ */
+typedef struct {
+    long offset;    /**< First sample of the segment (note-relative) */
+    long length;    /**< Number of samples in the segment */
+    float level;    /**< Envelope level at the first sample */
+    float delta;    /**< Level change per sample */
+} EnvSegment;
+
+/**
+ * @brief Note event prepared for rendering
+ *
+ * Everything that does not change per sample is computed once here, so
+ * the render loop only evaluates ramps and the oscillator.
+ */
+typedef struct {
+    long start;                 /**< Absolute note-on sample */
+    long length;                /**< Samples including the release tail */
+    WaveType wave;              /**< Oscillator waveform */
+    float gain;                 /**< Waveform gain times MASTER_GAIN */
+    double phase;               /**< Oscillator phase at note-on (cycles) */
+    double step;                /**< Phase increment per sample after the glide */
+    double glide_step;          /**< Phase increment at note-on while gliding */
+    long glide_length;          /**< Glide duration in samples (0 = no slide) */
+    EnvSegment segments[VOICE_MAX_SEGMENTS];
+    int segment_count;
+} Voice;
+
+/**
+ * @brief Returns the output gain applied to a waveform
+ * @param wave Waveform type
+ * @return Loudness compensation factor (without MASTER_GAIN)
+ *
+ * Square and sawtooth carry much more energy than a sine of the same
+ * amplitude, so they are attenuated to keep perceived levels similar.
+ */
+float voice_wave_gain(WaveType wave);
+
+/**
+ * @brief Prepares a voice from a note event
+ * @param voice Output voice
+ * @param note Note event captured by the parser
+ * @param sample_rate Sample rate in Hz
+ * @param phase Phase alignment policy
+ *
+ * Splits the ADSR envelope into linear segments following the same
+ * attack → decay → sustain → release rules as the reference envelope.
+ */
+void voice_init(Voice* voice, const NoteEvent* note, int sample_rate, VoicePhase phase);
+
+/**
+ * @brief Checks whether two voices render the same samples up to a time shift
+ * @param a First voice
+ * @param b Second voice
+ * @return true if every field except the start sample is identical
+ */
+bool voice_same_shape(const Voice* a, const Voice* b);
+
+/**
+ * @brief Switches a voice to the cheapest oscillator of similar sound
+ * @param voice Prepared voice
+ *
+ * Used for preview renders: sines are rendered as triangles, which skips
+ * the polynomial of the sine approximation. The gain is left unchanged so
+ * the mix keeps its balance. Other waveforms are already as cheap.
+ */
+void voice_use_draft_oscillator(Voice* voice);
+
+/**
+ * @brief Hashes every field that affects the rendered samples
+ * @param voice Prepared voice
+ * @return 64-bit hash (start is ignored, so equal shapes at different
+ *         times hash alike)
+ */
+uint64_t voice_hash(const Voice* voice);
+
+/**
+ * @brief Mixes a voice into an output window
+ * @param voice Prepared voice
+ * @param out Output buffer holding absolute samples [from, to)
+ * @param from First absolute sample of the window
+ * @param to One past the last absolute sample of the window
+ *
+ * Only the part of the voice overlapping the window is rendered. Each
+ * sample is a pure function of the voice and its index, so rendering a
+ * note in one window or split across several gives identical output.
+ */
+void voice_render(const Voice* voice, float* out, long from, long to);
+
+#endif /* VOICE_H */
@@ -2,12 +2,21 @@
  * @file wav_writer.h
  * @brief WAV file export interface
  * @author joaomrpimentel
- * @version 1.0
+ * @version 1.3
  */
 
 #ifndef WAV_WRITER_H
 #define WAV_WRITER_H
 
+#include <stdbool.h>
+#include <stdint.h>
+#include "pcm_writer.h"
+
+/**
+ * @brief Opaque incremental WAV writer
+ */
+typedef struct WavWriter WavWriter;
+
 /**
  * @brief Exports audio buffer to WAV file
  * @param filename Output file path
@@ -24,4 +33,54 @@
  */
 void write_wav_file(const char* filename, float* buffer, long sample_count);
 
-#endif /* WAV_WRITER_H */
\ No newline at end of file
+/**
+ * @brief Creates a WAV file for incremental writing
+ * @param filename Output file path
+ * @param sample_rate Sample rate in Hz
+ * @return Writer handle, or NULL on error
+ *
+ * The header is written with placeholder sizes that are patched by
+ * wav_writer_close(), so the length does not need to be known up front.
+ */
+WavWriter* wav_writer_open(const char* filename, int sample_rate);
+
+/**
+ * @brief Creates a WAV file with a chosen sample encoding
+ * @param filename Output file path
+ * @param sample_rate Sample rate in Hz
+ * @param format PCM_FLOAT32 (format code 3) or PCM_INT16/PCM_INT24 (format code 1)
+ * @param dither Add triangular dither before integer quantization
+ * @return Writer handle, or NULL on error
+ */
+WavWriter* wav_writer_open_format(const char* filename, int sample_rate,
+                                  PcmFormat format, bool dither);
+
+/**
+ * @brief Appends samples to the data chunk
+ * @param writer Open writer
+ * @param samples Float PCM samples in range [-1.0, 1.0]
+ * @param count Number of samples
+ * @return 0 on success, -1 on write error or if the data chunk would
+ *         exceed the 4 GiB a RIFF size field can describe (nothing is
+ *         written then)
+ */
+int wav_writer_write(WavWriter* writer, const float* samples, long count);
+
+/**
+ * @brief Appends samples already converted to 24-bit integers
+ * @param writer Writer opened with PCM_INT24 and no dither
+ * @param pcm Samples scaled by INT24_SCALE
+ * @param count Number of samples
+ * @return 0 on success, -1 on write error or past the 4 GiB limit
+ *         (see wav_writer_write)
+ */
+int wav_writer_write_pcm24(WavWriter* writer, const int32_t* pcm, long count);
+
+/**
+ * @brief Patches the RIFF and data sizes, closes the file and frees the writer
+ * @param writer Writer to close (NULL is ignored)
+ * @return 0 on success, -1 if any write failed
+ */
+int wav_writer_close(WavWriter* writer);
+
+#endif /* WAV_WRITER_H */
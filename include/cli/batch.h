@@ -0,0 +1,32 @@
+/**
+ * @file batch.h
+ * @brief Compilation of many JSHL files in one process
+ * @author joaomrpimentel
+ * @version 1.0
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "cli.h"
+
+/**
+ * @brief Compiles every input of a batch on a worker pool
+ * @param config Parsed configuration (cli_is_batch() must be true)
+ * @return Number of files that failed, or -1 if the batch could not start
+ *
+ * Inputs come from the manifest (config->batch_file) followed by the
+ * command-line inputs. A manifest line is "<input.jshl> [output]"; blank
+ * lines and lines starting with '#' are skipped. Inputs without an
+ * explicit output are written to <output_dir>/<name>.<format> (output_dir
+ * defaults to the current directory).
+ *
+ * Each worker runs whole files (see compile_job_run), so parsing,
+ * rendering and encoding of different files overlap. Larger sources are
+ * started first to shorten the tail of the batch. A failing file is
+ * reported and skipped without affecting the others; a summary is
+ * printed at the end.
+ */
+int batch_run(const CliConfig* config);
+
+#endif /* BATCH_H */
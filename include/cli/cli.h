@@ -2,31 +2,53 @@
  * @file cli.h
  * @brief Command-line interface argument parser
  * @author joaomrpimentel
- * @version 1.0
+ * @version 1.3
  */
 
 #ifndef CLI_H
 #define CLI_H
 
 #include <stdbool.h>
+#include "jshl_compiler.h"
+#include "voice.h"
+#include "pcm_writer.h"
 
-/**
- * @brief Supported output audio formats
- */
-typedef enum {
-    FORMAT_WAV,
-    FORMAT_RAW,
-    FORMAT_UNKNOWN
-} OutputFormat;
+/** Compiler version, reported by --version and part of output cache keys */
+#define CLI_VERSION "1.0.0"
+
+/** Most output files of a single compilation */
+#define CLI_MAX_OUTPUTS 8
+
+/** Sample rate of --preview renders unless --rate is given */
+#define CLI_PREVIEW_SAMPLE_RATE 11025
 
 /**
  * @brief Command-line configuration structure
  */
 typedef struct {
     const char* input_file;      /**< Input JSHL file path */
-    const char* output_file;     /**< Output audio file path */
-    OutputFormat format;         /**< Output format (WAV, RAW) */
+    const char* output_files[CLI_MAX_OUTPUTS]; /**< Output audio file paths */
+    int output_count;            /**< Number of outputs (at least 1 unless batch) */
+    OutputFormat format;         /**< Format of the first output, and of batch outputs */
+    bool format_set;             /**< Format given with -f (overrides extensions) */
+    const char* batch_file;      /**< Batch manifest path (NULL = none) */
+    const char* output_dir;      /**< Output directory for batch inputs (NULL = none) */
+    char** input_files;          /**< Batch inputs given on the command line */
+    int input_count;             /**< Number of entries in input_files */
+    int jobs;                    /**< Files compiled concurrently in batch mode (0 = all CPUs) */
     int sample_rate;             /**< Sample rate in Hz */
+    bool preview;                /**< Low-rate render with draft oscillators */
+    double range_from;           /**< Start of the rendered range in seconds */
+    double range_to;             /**< End of the rendered range in seconds (< 0 = song end) */
+    bool incremental;            /**< Reuse the previous render through its cache file */
+    const char* cache_dir;       /**< Output cache directory (NULL = no cache) */
+    int cache_size_mb;           /**< Output cache size limit in MB */
+    int threads;                 /**< Render and FLAC encoder threads (0 = all CPUs) */
+    VoicePhase phase;            /**< Oscillator phase at note-on */
+    bool loop_clips;             /**< Render repeated loop iterations once */
+    int note_cache_mb;           /**< Rendered-note cache size (0 = off) */
+    PcmFormat pcm_format;        /**< Sample encoding of WAV and RAW output */
+    bool dither;                 /**< Dither integer WAV and RAW output */
     bool verbose;                /**< Enable verbose output */
     bool show_help;              /**< Show help message */
     bool show_version;           /**< Show version info */
@@ -41,6 +63,22 @@ typedef struct {
  */
 bool cli_parse_args(int argc, char* argv[], CliConfig* config);
 
+/**
+ * @brief Tells whether several files are compiled in one run
+ * @param config Parsed configuration
+ * @return true if --batch or --output-dir was given
+ */
+bool cli_is_batch(const CliConfig* config);
+
+/**
+ * @brief Chooses the format of an output file
+ * @param config Parsed configuration
+ * @param output_file Output path
+ * @return The -f format if given, else the one implied by the extension,
+ *         else config->format
+ */
+OutputFormat cli_output_format(const CliConfig* config, const char* output_file);
+
 /**
  * @brief Displays usage information
  * @param program_name Name of the program (argv[0])
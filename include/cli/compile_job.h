@@ -0,0 +1,53 @@
+/**
+ * @file compile_job.h
+ * @brief Compilation of one JSHL file to audio files
+ * @author joaomrpimentel
+ * @version 1.1
+ */
+
+#ifndef COMPILE_JOB_H
+#define COMPILE_JOB_H
+
+#include <stddef.h>
+#include "jshl_compiler.h"
+#include "cli.h"
+
+/**
+ * @brief Destination of a compilation
+ */
+typedef struct {
+    const char* file;       /**< Output audio path */
+    OutputFormat format;    /**< Encoding of the file */
+} CompileOutput;
+
+/**
+ * @brief Outcome of a compilation
+ */
+typedef struct {
+    size_t note_count;      /**< Notes parsed (0 = nothing was rendered) */
+    long total_samples;     /**< Samples rendered */
+    int failed_outputs;     /**< Outputs that could not be written */
+} CompileResult;
+
+/**
+ * @brief Maps, parses, renders and encodes one input file
+ * @param config Options shared by every file (rendering, verbosity)
+ * @param input_file JSHL source path
+ * @param outputs Files to write (1..CLI_MAX_OUTPUTS)
+ * @param output_count Number of outputs
+ * @param result Output statistics
+ * @return 0 on success, -1 on error (already reported on stderr)
+ *
+ * The song is rendered once and every chunk is fanned out to one encoder
+ * thread per output. A failing output is reported and dropped while the
+ * others complete; the call then returns -1.
+ *
+ * Every allocation is owned by the call, so jobs may run concurrently on
+ * different files. A source without notes is reported, leaves the output
+ * untouched and returns 0 with result->note_count == 0.
+ */
+int compile_job_run(const CliConfig* config, const char* input_file,
+                    const CompileOutput* outputs, int output_count,
+                    CompileResult* result);
+
+#endif /* COMPILE_JOB_H */
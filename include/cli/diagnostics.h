@@ -0,0 +1,76 @@
+/**
+ * @file diagnostics.h
+ * @brief Error reporting for the command-line tools
+ * @author joaomrpimentel
+ * @version 1.1
+ *
+ * The core, parser and audio modules only return status codes, so they
+ * can be linked into libjshl. The cli_ wrappers below belong to the CLI
+ * layer: they call those modules, then print to stderr or exit on
+ * failure, for the jshl executable and the benchmarks. libjshl never
+ * contains them.
+ */
+
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <stdarg.h>
+#include "jshl_compiler.h"
+#include "source.h"
+#include "ir.h"
+
+/**
+ * @brief Prints a parser diagnostic to stderr (a ProgramReport)
+ * @param format printf-style message, including its "Warning:" prefix
+ * @param args Message arguments
+ */
+void diagnostics_print(const char* format, va_list args);
+
+/**
+ * @brief Opens a file for parsing
+ * @param source Output source
+ * @param path File to open
+ * @return 0 on success, -1 on error (message printed to stderr)
+ *
+ * Same as source_map, reporting the error.
+ */
+int cli_source_open(Source* source, const char* path);
+
+/**
+ * @brief Initializes a note list with default capacity, exiting on failure
+ * @param list Pointer to NoteList structure to initialize
+ */
+void cli_note_list_init(NoteList* list);
+
+/**
+ * @brief Adds a note event to the list, exiting on failure
+ * @param list Pointer to target NoteList
+ * @param note NoteEvent structure to add
+ *
+ * Same as note_list_push otherwise.
+ */
+void cli_note_list_add(NoteList* list, NoteEvent note);
+
+/**
+ * @brief Initializes an empty program that prints its diagnostics,
+ *        exiting on failure
+ * @param program Program to initialize
+ */
+void cli_program_init(Program* program);
+
+/**
+ * @brief Main entry point for JSHL source code parsing
+ * @param code Null-terminated JSHL source code string
+ * @param list Output note list to populate
+ *
+ * Compiles the source to IR in one pass (see parse_jshl_program) and
+ * evaluates it from the default synthesizer state:
+ * - Waveform: SQUARE
+ * - Envelope: A=0.01s, D=0s, S=1.0, R=0.01s
+ * - Slide: 0s (disabled)
+ *
+ * Diagnostics are printed; allocation failures exit.
+ */
+void cli_parse_jshl(char* code, NoteList* list);
+
+#endif /* DIAGNOSTICS_H */
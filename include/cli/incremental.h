@@ -0,0 +1,96 @@
+/**
+ * @file incremental.h
+ * @brief Incremental recompilation through a sidecar render cache
+ * @author joaomrpimentel
+ * @version 1.0
+ */
+
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "jshl_compiler.h"
+#include "source.h"
+#include "synth.h"
+#include "pcm_writer.h"
+
+/** Extension appended to the first output's path to name its cache */
+#define INCREMENTAL_CACHE_EXTENSION ".jshlc"
+
+/**
+ * @brief Sample range and shape of one note, as stored in the cache
+ */
+typedef struct {
+    int64_t start;      /**< Note-on sample */
+    int64_t end;        /**< One past the last sample of the release */
+    uint64_t hash;      /**< voice_hash of the note */
+} CachedNote;
+
+/**
+ * @brief Recompilation against the previous render of the same output
+ *
+ * The cache holds the previous render's clipped samples and the range
+ * and shape of each of its notes. Comparing those with the new notes
+ * gives the longest unchanged prefix and the longest suffix that is
+ * unchanged up to a constant time shift (the notes after an edit move
+ * together). Every output sample is a function of the voices sounding at
+ * it, so samples before the first changed note are copied from the old
+ * render, samples after the last changed note's release are copied from
+ * the old render shifted by that offset, and only the span in between is
+ * synthesized. With song-clock phase a shifted note starts at a
+ * different oscillator phase and so counts as changed.
+ */
+typedef struct {
+    Source previous;            /**< Mapped old cache (data NULL if none was usable) */
+    const float* old_samples;   /**< Old render (in previous) */
+    long old_total;             /**< Samples of the old render */
+    CachedNote* notes;          /**< Notes of the new render */
+    size_t note_count;
+    long total_samples;         /**< Samples of the new render */
+    long render_from;           /**< First synthesized sample */
+    long render_to;             /**< One past the last synthesized sample */
+    long shift;                 /**< New time minus old time after the edit */
+    long position;              /**< Next sample to produce */
+    PcmWriter* writer;          /**< New cache being written (NULL = not saved) */
+    char path[4096];            /**< Cache file */
+    char temp_path[4096];       /**< New cache until it is complete */
+} IncrementalRender;
+
+/**
+ * @brief Loads the previous cache and plans what to synthesize
+ * @param render Render to initialize
+ * @param cache_path Cache file (need not exist)
+ * @param list New notes
+ * @param stream Initialized stream over the same notes and options
+ * @return 0 on success, -1 on allocation failure
+ *
+ * A missing, stale (other sample rate, phase mode or draft setting) or
+ * damaged cache just leads to a full render. Failing to create the new
+ * cache is reported as a warning; the render goes on without it.
+ */
+int incremental_open(IncrementalRender* render, const char* cache_path,
+                     const NoteList* list, const SynthStream* stream);
+
+/**
+ * @brief Produces the next samples of the new render
+ * @param render Open render
+ * @param stream Stream used for the changed span (seeked as needed)
+ * @param out Output buffer with room for 'frames' samples
+ * @param frames Maximum number of samples to produce
+ * @return Samples written (0 at the end), or -1 on error
+ *
+ * The samples are also appended to the new cache.
+ */
+long incremental_read(IncrementalRender* render, SynthStream* stream, float* out, long frames);
+
+/**
+ * @brief Finishes a render
+ * @param render Render to close
+ * @param complete Every sample was produced: replace the old cache
+ *        with the new one (atomically, by rename)
+ * @return 0 on success, -1 if the new cache could not be saved
+ */
+int incremental_close(IncrementalRender* render, bool complete);
+
+#endif /* INCREMENTAL_H */
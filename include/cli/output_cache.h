@@ -0,0 +1,85 @@
+/**
+ * @file output_cache.h
+ * @brief Content-addressed on-disk cache of encoded outputs
+ * @author joaomrpimentel
+ * @version 1.1
+ */
+
+#ifndef OUTPUT_CACHE_H
+#define OUTPUT_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "jshl_compiler.h"
+#include "cli.h"
+#include "sha256.h"
+
+/** Cache size limit when --cache-size is not given, in MB */
+#define OUTPUT_CACHE_DEFAULT_MB 1024
+
+/**
+ * @brief Bumped whenever rendering or encoding changes the bytes an
+ *        unchanged song produces, so older entries stop matching
+ */
+#define OUTPUT_CACHE_REVISION 2
+
+/**
+ * @brief Identity of one encoded output
+ */
+typedef struct {
+    unsigned char digest[SHA256_DIGEST_SIZE];   /**< SHA-256 of the key material */
+} OutputCacheKey;
+
+/**
+ * @brief Computes the cache key of one output of a song
+ * @param key Output key
+ * @param list Expanded notes of the song
+ * @param config Rendering and encoding options
+ * @param format Format of the output
+ *
+ * The key covers every note after parsing and loop expansion (timing,
+ * pitch and synthesizer state), so sources that differ only in comments,
+ * layout, note spelling or how they use LOOP share entries. It also
+ * covers the settings the encoded bytes depend on (sample rate, phase
+ * mode, preview, loop clips, range, format, bit depth, dither), the
+ * compiler version and the libFLAC or LAME version. Thread counts, the
+ * note cache and --incremental do not change the output and are left out.
+ *
+ * The key is a SHA-256 digest and names the entry, so a hit is trusted
+ * without comparing contents; two songs sharing an entry by accident
+ * would take a collision of the full 256 bits.
+ */
+void output_cache_key(OutputCacheKey* key, const NoteList* list, const CliConfig* config,
+                      OutputFormat format);
+
+/**
+ * @brief Copies a cached output to its destination
+ * @param dir Cache directory
+ * @param key Output key
+ * @param format Format of the output
+ * @param output Destination path
+ * @return 1 on a hit, 0 on a miss, -1 if the destination could not be written
+ *
+ * A hit marks the entry as most recently used.
+ */
+int output_cache_fetch(const char* dir, const OutputCacheKey* key, OutputFormat format,
+                       const char* output);
+
+/**
+ * @brief Adds a freshly written output to the cache
+ * @param dir Cache directory (created if missing)
+ * @param max_bytes Size limit of the cache
+ * @param key Output key
+ * @param format Format of the output
+ * @param output Path of the written output
+ * @return 0 on success, -1 if the entry could not be saved (reported as a warning)
+ *
+ * The entry is written to a temporary file and renamed into place, so
+ * concurrent jshl processes sharing the directory never see a partial
+ * entry. Least recently used entries are then deleted until the cache
+ * fits in max_bytes.
+ */
+int output_cache_store(const char* dir, size_t max_bytes, const OutputCacheKey* key,
+                       OutputFormat format, const char* output);
+
+#endif /* OUTPUT_CACHE_H */
@@ -0,0 +1,94 @@
+/**
+ * @file arena.h
+ * @brief Bump allocator for compilation-lifetime data
+ * @author joaomrpimentel
+ * @version 1.0
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/** Default chunk size requested from the system */
+#define ARENA_CHUNK_SIZE (64 * 1024)
+
+/**
+ * @brief Block of memory carved up by the arena
+ */
+typedef struct ArenaChunk {
+    struct ArenaChunk* next;
+    size_t capacity;
+    size_t used;
+} ArenaChunk;
+
+/**
+ * @brief Arena: allocations are only released all at once
+ *
+ * Small allocations are carved from chunks that are kept across
+ * arena_reset(), so a process compiling many files stops calling malloc
+ * once the arena has grown to the largest compilation. Allocations above
+ * a quarter chunk get a block of their own that can be resized in place,
+ * so growing arrays (note columns, IR code) do not leave copies behind.
+ */
+typedef struct Arena {
+    ArenaChunk* head;       /**< First chunk */
+    ArenaChunk* current;    /**< Chunk serving allocations */
+    ArenaChunk* large;      /**< Dedicated blocks of large allocations */
+    void* last;             /**< Most recent allocation (may be grown in place) */
+    size_t chunk_size;      /**< Minimum size of new chunks */
+} Arena;
+
+/**
+ * @brief Initializes an empty arena (no memory is allocated yet)
+ * @param arena Arena to initialize
+ * @param chunk_size Minimum chunk size in bytes (0 for ARENA_CHUNK_SIZE)
+ */
+void arena_init(Arena* arena, size_t chunk_size);
+
+/**
+ * @brief Allocates memory aligned for any object type
+ * @param arena Arena to allocate from, or NULL to use malloc
+ * @param size Bytes to allocate
+ * @return Pointer to the memory, or NULL on failure
+ */
+void* arena_alloc(Arena* arena, size_t size);
+
+/**
+ * @brief Resizes an allocation, keeping its contents
+ * @param arena Arena owning ptr, or NULL to use realloc
+ * @param ptr Previous allocation (may be NULL)
+ * @param old_size Current size of ptr in bytes
+ * @param new_size Requested size in bytes
+ * @return Resized memory, or NULL on failure (ptr is left untouched)
+ *
+ * Large allocations and the most recent small one grow in place when
+ * possible.
+ */
+void* arena_realloc(Arena* arena, void* ptr, size_t old_size, size_t new_size);
+
+/**
+ * @brief Releases one allocation
+ * @param arena Arena owning ptr, or NULL to use free
+ * @param ptr Allocation to release
+ *
+ * A no-op for arena memory, which is released by arena_reset().
+ */
+void arena_release(Arena* arena, void* ptr);
+
+/**
+ * @brief Releases every allocation, keeping the chunks for reuse
+ * @param arena Arena to reset
+ *
+ * Chunks are recycled lazily, so the cost is independent of the number
+ * of allocations; only the few large blocks are returned to the system.
+ */
+void arena_reset(Arena* arena);
+
+/**
+ * @brief Returns all chunks to the system
+ * @param arena Arena to free
+ */
+void arena_free(Arena* arena);
+
+#endif /* ARENA_H */
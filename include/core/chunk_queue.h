@@ -0,0 +1,106 @@
+/**
+ * @file chunk_queue.h
+ * @brief Bounded single-producer/multi-consumer queue of audio chunks
+ * @author joaomrpimentel
+ * @version 1.1
+ */
+
+#ifndef CHUNK_QUEUE_H
+#define CHUNK_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Most consumers a queue can feed */
+#define CHUNK_QUEUE_MAX_CONSUMERS 8
+
+/**
+ * @brief Slot of the queue
+ */
+typedef struct {
+    float* samples;     /**< Float PCM, chunk_frames entries */
+    int32_t* pcm24;     /**< Same samples as 24-bit integers (NULL unless requested) */
+    long frames;        /**< Valid samples, set by the producer before pushing */
+} Chunk;
+
+/**
+ * @brief Opaque queue handle
+ *
+ * The queue owns a fixed ring of chunks. The producer fills a free chunk
+ * and pushes it; every consumer pops it in turn and releases it once the
+ * samples are no longer needed. A chunk is reused only after all
+ * consumers released it, and the producer blocks while every chunk is
+ * in flight, so memory stays bounded however far ahead it runs.
+ */
+typedef struct ChunkQueue ChunkQueue;
+
+/**
+ * @brief Creates a queue
+ * @param depth Number of chunks (at least 2 for any overlap)
+ * @param chunk_frames Capacity of each chunk in samples
+ * @param consumers Number of consumers (1..CHUNK_QUEUE_MAX_CONSUMERS)
+ * @param with_pcm24 Allocate the pcm24 side of each chunk
+ * @return New queue, or NULL on allocation failure
+ */
+ChunkQueue* chunk_queue_create(int depth, long chunk_frames, int consumers, bool with_pcm24);
+
+/**
+ * @brief Waits for a free chunk (producer)
+ * @param queue Target queue
+ * @return Chunk to fill, or NULL if the queue was aborted or every
+ *         consumer detached
+ */
+Chunk* chunk_queue_acquire(ChunkQueue* queue);
+
+/**
+ * @brief Publishes the chunk returned by the last acquire (producer)
+ * @param queue Target queue
+ */
+void chunk_queue_push(ChunkQueue* queue);
+
+/**
+ * @brief Signals that no more chunks will be pushed (producer)
+ * @param queue Target queue
+ */
+void chunk_queue_close(ChunkQueue* queue);
+
+/**
+ * @brief Waits for a consumer's next chunk
+ * @param queue Source queue
+ * @param consumer Consumer index (0..consumers-1)
+ * @return Chunk, or NULL once the queue is closed and drained or aborted
+ */
+const Chunk* chunk_queue_pop(ChunkQueue* queue, int consumer);
+
+/**
+ * @brief Hands the chunk from the consumer's last pop back to the queue
+ * @param queue Source queue
+ * @param consumer Consumer index
+ */
+void chunk_queue_release(ChunkQueue* queue, int consumer);
+
+/**
+ * @brief Stops a consumer that gave up, e.g. after a write error
+ * @param queue Source queue
+ * @param consumer Consumer index
+ *
+ * The remaining consumers carry on; the producer no longer waits for
+ * this one. Must not be called while the consumer holds a popped chunk.
+ */
+void chunk_queue_detach(ChunkQueue* queue, int consumer);
+
+/**
+ * @brief Stops every side after an error
+ * @param queue Target queue
+ *
+ * Blocked and later calls to acquire and pop return NULL.
+ */
+void chunk_queue_abort(ChunkQueue* queue);
+
+/**
+ * @brief Frees the queue and its chunks
+ * @param queue Queue to destroy (NULL is ignored); no thread may still use it
+ */
+void chunk_queue_destroy(ChunkQueue* queue);
+
+#endif /* CHUNK_QUEUE_H */
@@ -0,0 +1,33 @@
+/**
+ * @file hash.h
+ * @brief FNV-1a hashing helpers
+ * @author joaomrpimentel
+ * @version 1.0
+ */
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** FNV-1a 64-bit offset basis */
+#define HASH_SEED 14695981039346656037ULL
+
+/**
+ * @brief Folds a block of bytes into a running FNV-1a hash
+ * @param hash Current hash (HASH_SEED for a new one)
+ * @param data Bytes to hash
+ * @param size Number of bytes
+ * @return Updated hash
+ */
+static inline uint64_t hash_bytes(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+#endif /* HASH_H */
@@ -0,0 +1,92 @@
+/**
+ * @file note_index.h
+ * @brief Interval index answering "which notes sound in [from, to)"
+ * @author joaomrpimentel
+ * @version 1.0
+ */
+
+#ifndef NOTE_INDEX_H
+#define NOTE_INDEX_H
+
+#include <stddef.h>
+
+/**
+ * @brief Node of the index: one note's sample range
+ *
+ * The fields a query reads are kept together so each visited node costs
+ * a single cache line.
+ */
+typedef struct {
+    long start;         /**< First sample */
+    long end;           /**< One past the last sample */
+    long max_end;       /**< Largest end in the subtree rooted here */
+    size_t note;        /**< Note index passed to note_index_build */
+} NoteInterval;
+
+/**
+ * @brief Static interval index over note sample ranges
+ *
+ * Intervals are sorted by start and laid out as an implicit binary tree
+ * over the sorted array: the element at position x is a node whose level
+ * is the number of trailing 1 bits of x, and max_end holds the largest
+ * end in its subtree. A query descends only into subtrees that can reach
+ * the window, so it costs O(log n + k) for k hits no matter how long
+ * individual release tails are or how they interleave.
+ */
+typedef struct {
+    NoteInterval* items; /**< Sorted by start, ties in list order */
+    size_t count;
+    int levels;         /**< Level of the root */
+} NoteIndex;
+
+/**
+ * @brief Called for every interval overlapping a query
+ * @param note Note index passed to note_index_build
+ * @param context Caller data
+ */
+typedef void (*NoteIndexVisit)(size_t note, void* context);
+
+/**
+ * @brief Builds an index over intervals [starts[i], ends[i])
+ * @param index Index to initialize
+ * @param starts Start sample of each note
+ * @param ends End sample of each note (exclusive)
+ * @param count Number of notes
+ * @return 0 on success, -1 on allocation failure
+ *
+ * Costs O(n) when starts are already ascending (the parser's output) and
+ * O(n log n) otherwise.
+ */
+int note_index_build(NoteIndex* index, const long* starts, const long* ends, size_t count);
+
+/**
+ * @brief Visits every note sounding in [from, to)
+ * @param index Built index
+ * @param from First sample of the window
+ * @param to One past the last sample (from == to asks for notes
+ *        sounding across the point 'from', started before it)
+ * @param visit Callback for each note with start < to and end > from
+ * @param context Passed to visit
+ * @return Number of notes visited
+ *
+ * Notes are visited by ascending start, ties in list order, which for a
+ * list ordered by start time is list order.
+ */
+size_t note_index_query(const NoteIndex* index, long from, long to,
+                        NoteIndexVisit visit, void* context);
+
+/**
+ * @brief Counts the notes starting before a sample
+ * @param index Built index
+ * @param sample Absolute sample index
+ * @return Number of notes whose start is below 'sample'
+ */
+size_t note_index_starts_before(const NoteIndex* index, long sample);
+
+/**
+ * @brief Releases the arrays of an index
+ * @param index Index to free
+ */
+void note_index_free(NoteIndex* index);
+
+#endif /* NOTE_INDEX_H */
@@ -2,26 +2,56 @@
  * @file note_list.h
  * @brief Dynamic note list data structure interface
  * @author joaomrpimentel
- * @version 1.0
+ * @version 1.3
  */
 
 #ifndef NOTE_LIST_H
 #define NOTE_LIST_H
 
 #include "jshl_compiler.h"
+#include "arena.h"
 
 /**
- * @brief Initializes a note list with default capacity
+ * @brief Initializes a note list whose storage comes from an arena
  * @param list Pointer to NoteList structure to initialize
+ * @param arena Arena owning the columns (NULL to use malloc)
+ * @return 0 on success, -1 on allocation failure
+ *
+ * Arena-backed lists are released with the arena; note_list_free is
+ * optional for them.
  */
-void note_list_init(NoteList* list);
+int note_list_init_arena(NoteList* list, Arena* arena);
 
 /**
  * @brief Adds a note event to the list, expanding capacity if needed
  * @param list Pointer to target NoteList
  * @param note NoteEvent structure to add
+ * @return 0 on success, -1 on allocation failure (the list is unchanged)
+ *
+ * The note's SynthState is interned: notes sharing a state store only a
+ * 32-bit reference. A last_freq equal to the previous note's frequency
+ * is kept as a flag, so slides do not create new states. cli_note_list_add
+ * (diagnostics.h) is the same operation but exits on failure.
  */
-void note_list_add(NoteList* list, NoteEvent note);
+int note_list_push(NoteList* list, NoteEvent note);
+
+/**
+ * @brief Reconstructs a note event
+ * @param list Source NoteList
+ * @param index Note index (must be < list->size)
+ * @param note Output note, identical to the one given to note_list_push
+ */
+void note_list_get(const NoteList* list, size_t index, NoteEvent* note);
+
+/**
+ * @brief Returns the interned synthesizer state of a note
+ * @param list Source NoteList
+ * @param index Note index
+ * @return Shared state (last_freq is 0 for legato notes, see note_list_get)
+ */
+static inline const SynthState* note_list_state(const NoteList* list, size_t index) {
+    return &list->states[list->state[index] & NOTE_STATE_INDEX_MASK];
+}
 
 /**
  * @brief Frees all memory associated with a note list
@@ -29,4 +59,24 @@ void note_list_add(NoteList* list, NoteEvent note);
  */
 void note_list_free(NoteList* list);
 
+/**
+ * @brief Initializes an empty loop list
+ * @param loops Pointer to LoopList structure to initialize
+ */
+void loop_list_init(LoopList* loops);
+
+/**
+ * @brief Adds a loop span to the list, expanding capacity if needed
+ * @param loops Pointer to target LoopList
+ * @param span LoopSpan structure to add
+ * @return 0 on success, -1 on allocation failure
+ */
+int loop_list_add(LoopList* loops, LoopSpan span);
+
+/**
+ * @brief Frees all memory associated with a loop list
+ * @param loops Pointer to LoopList to deallocate
+ */
+void loop_list_free(LoopList* loops);
+
 #endif /* NOTE_LIST_H */
\ No newline at end of file
@@ -2,12 +2,31 @@
  * @file note_table.h
  * @brief Musical note frequency lookup table
  * @author joaomrpimentel
- * @version 1.1
+ * @version 1.2
  */
 
 #ifndef NOTE_TABLE_H
 #define NOTE_TABLE_H
 
+#include <stddef.h>
+
+/** Number of MIDI notes */
+#define NOTE_MIDI_COUNT 128
+
+/** @brief Frequency in Hz of each MIDI note (A4 = 69 = 440 Hz) */
+extern const float note_freq_table[NOTE_MIDI_COUNT];
+
+/**
+ * @brief Converts a note name to its MIDI number in one pass
+ * @param name Note name bytes, e.g. "C4", "F#3", "Bb5" (need not be NUL-terminated)
+ * @param length Number of bytes in name
+ * @return MIDI note number (0-127), or -1 if invalid
+ *
+ * The letter may be upper or lower case; '#' and 'b' are accidentals.
+ * Characters after the octave number are ignored.
+ */
+int note_name_to_midi(const char* name, size_t length);
+
 /**
  * @brief Converts scientific pitch notation to frequency
  * @param note_name String in format "C4", "F#3", "Bb5", etc.
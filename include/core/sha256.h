@@ -0,0 +1,48 @@
+/**
+ * @file sha256.h
+ * @brief SHA-256 message digest (FIPS 180-4)
+ * @author joaomrpimentel
+ * @version 1.0
+ */
+
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Size of a digest in bytes */
+#define SHA256_DIGEST_SIZE 32
+
+/**
+ * @brief Running digest of a message fed in pieces
+ */
+typedef struct {
+    uint32_t state[8];      /**< Intermediate hash value */
+    uint64_t length;        /**< Bytes hashed so far */
+    unsigned char block[64]; /**< Bytes waiting for a full block */
+    size_t used;            /**< Bytes in block */
+} Sha256;
+
+/**
+ * @brief Starts a new digest
+ * @param sha Context to initialize
+ */
+void sha256_init(Sha256* sha);
+
+/**
+ * @brief Appends bytes to the message
+ * @param sha Context
+ * @param data Bytes to hash
+ * @param size Number of bytes
+ */
+void sha256_update(Sha256* sha, const void* data, size_t size);
+
+/**
+ * @brief Finishes the message and returns its digest
+ * @param sha Context (must be initialized again before reuse)
+ * @param digest Output, SHA256_DIGEST_SIZE bytes
+ */
+void sha256_final(Sha256* sha, unsigned char digest[SHA256_DIGEST_SIZE]);
+
+#endif /* SHA256_H */
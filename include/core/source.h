@@ -0,0 +1,43 @@
+/**
+ * @file source.h
+ * @brief Read-only access to source files, memory-mapped when possible
+ * @author joaomrpimentel
+ * @version 1.3
+ */
+
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Contents of a source file
+ *
+ * The bytes are not NUL-terminated: always use size.
+ */
+typedef struct {
+    const char* data;   /**< File contents */
+    size_t size;        /**< Length in bytes */
+    bool mapped;        /**< data is an mmap'ed view (otherwise malloc'ed) */
+} Source;
+
+/**
+ * @brief Opens a file for parsing
+ * @param source Output source
+ * @param path File to open
+ * @return 0 on success, -1 on error (nothing is printed; see cli_source_open
+ *         in diagnostics.h for the reporting variant)
+ *
+ * Regular files are mapped read-only, so no copy of the text is made.
+ * Pipes and other unmappable files are read into memory instead.
+ */
+int source_map(Source* source, const char* path);
+
+/**
+ * @brief Unmaps or frees a source
+ * @param source Source to close
+ */
+void source_close(Source* source);
+
+#endif /* SOURCE_H */
@@ -0,0 +1,58 @@
+/**
+ * @file thread_pool.h
+ * @brief Fixed-size worker thread pool interface
+ * @author joaomrpimentel
+ * @version 1.0
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+/**
+ * @brief Task executed by a worker thread
+ * @param arg User pointer given to thread_pool_submit()
+ */
+typedef void (*ThreadPoolTask)(void* arg);
+
+/**
+ * @brief Opaque thread pool handle
+ */
+typedef struct ThreadPool ThreadPool;
+
+/**
+ * @brief Returns the number of online CPUs
+ * @return CPU count, at least 1
+ */
+int thread_pool_cpu_count(void);
+
+/**
+ * @brief Starts a pool of worker threads
+ * @param threads Number of workers (values < 1 use thread_pool_cpu_count())
+ * @return New pool, or NULL on allocation or thread creation failure
+ */
+ThreadPool* thread_pool_create(int threads);
+
+/**
+ * @brief Queues a task for execution
+ * @param pool Target pool
+ * @param task Function to run on a worker
+ * @param arg Argument passed to the task
+ * @return 0 on success, -1 on allocation failure
+ *
+ * Tasks start in submission order; completion order is unspecified.
+ */
+int thread_pool_submit(ThreadPool* pool, ThreadPoolTask task, void* arg);
+
+/**
+ * @brief Blocks until every submitted task has finished
+ * @param pool Target pool
+ */
+void thread_pool_wait(ThreadPool* pool);
+
+/**
+ * @brief Waits for pending tasks, stops the workers and frees the pool
+ * @param pool Pool to destroy (NULL is ignored)
+ */
+void thread_pool_destroy(ThreadPool* pool);
+
+#endif /* THREAD_POOL_H */
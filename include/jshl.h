@@ -0,0 +1,169 @@
+/**
+ * @file jshl.h
+ * @brief Embeddable JSHL synthesizer (libjshl)
+ * @author joaomrpimentel
+ * @version 1.1
+ *
+ * Compiles JSHL source into a song object and renders it on demand into
+ * caller-owned buffers:
+ *
+ * @code
+ * JshlOptions options;
+ * JshlSong* song;
+ * jshl_options_init(&options);
+ * options.sample_rate = 48000;
+ * if (jshl_song_compile(text, strlen(text), &options, &song, NULL) != JSHL_OK) ...
+ * while ((frames = jshl_render_into(song, buffer, 512)) > 0) play(buffer, frames);
+ * jshl_song_free(song);
+ * @endcode
+ *
+ * Functions report failures through their return value and never exit;
+ * parser diagnostics are not printed. Songs are independent of each
+ * other, so different threads may use different songs at the same time;
+ * a single song must not be used by two threads at once.
+ */
+
+#ifndef JSHL_H
+#define JSHL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Result of a library call
+ */
+typedef enum {
+    JSHL_OK = 0,
+    JSHL_ERROR_INVALID_ARGUMENT = -1,   /**< NULL pointer or option out of range */
+    JSHL_ERROR_RESOURCES = -2,          /**< Out of memory or song too large */
+    JSHL_ERROR_IO = -3,                 /**< Source file could not be read */
+    JSHL_ERROR_SYNTAX = -4,             /**< Diagnostic raised in strict mode */
+    JSHL_ERROR_EMPTY = -5               /**< Source contains no notes */
+} JshlStatus;
+
+/**
+ * @brief Compilation options
+ */
+typedef struct {
+    int sample_rate;    /**< Output rate in Hz (8000..192000) */
+    bool note_phase;    /**< Restart oscillators at every note-on instead of
+                             following the song clock */
+    bool draft;         /**< Cheaper oscillators, for previews */
+    bool strict;        /**< Fail on unknown notes and unbalanced braces
+                             instead of skipping them */
+} JshlOptions;
+
+/**
+ * @brief Opaque compiled song with its playback position
+ */
+typedef struct JshlSong JshlSong;
+
+/**
+ * @brief Fills options with defaults (44.1 kHz, song-clock phase, lenient)
+ * @param options Options to initialize
+ */
+void jshl_options_init(JshlOptions* options);
+
+/**
+ * @brief Compiles JSHL source text into a song
+ * @param source Source bytes (need not be NUL-terminated)
+ * @param size Source length in bytes
+ * @param options Compilation options (NULL for defaults)
+ * @param song Output song, set only on success
+ * @param error_line If not NULL, receives the line of the first
+ *        diagnostic, or 0 if there was none
+ * @return JSHL_OK or an error status
+ *
+ * All memory the song needs for rendering is allocated here.
+ */
+JshlStatus jshl_song_compile(const char* source, size_t size, const JshlOptions* options,
+                             JshlSong** song, int* error_line);
+
+/**
+ * @brief Compiles a JSHL source file into a song
+ * @param path File to read
+ * @param options Compilation options (NULL for defaults)
+ * @param song Output song, set only on success
+ * @param error_line As for jshl_song_compile
+ * @return JSHL_OK or an error status
+ */
+JshlStatus jshl_song_compile_file(const char* path, const JshlOptions* options,
+                                  JshlSong** song, int* error_line);
+
+/**
+ * @brief Renders the next frames of a song
+ * @param song Compiled song
+ * @param out Buffer receiving up to 'frames' mono float samples in [-1, 1]
+ * @param frames Capacity of out
+ * @return Frames written (less than 'frames' only at the end of the song,
+ *         0 once it has ended), or a negative JshlStatus
+ *
+ * Never allocates, locks or performs I/O, and its cost is proportional
+ * to the frames and voices rendered, so it can be called from a real-time
+ * audio callback. Consecutive calls continue where the last one stopped;
+ * the concatenated output does not depend on how it was split.
+ */
+long jshl_render_into(JshlSong* song, float* out, long frames);
+
+/**
+ * @brief Moves playback back to the start of the song (never allocates)
+ * @param song Compiled song
+ */
+void jshl_song_rewind(JshlSong* song);
+
+/**
+ * @brief Moves playback to an arbitrary frame
+ * @param song Compiled song
+ * @param frame Next frame to render (clamped to the song length)
+ * @return JSHL_OK or JSHL_ERROR_INVALID_ARGUMENT
+ *
+ * Only the notes still sounding at 'frame' are looked at, so seeking
+ * late into a long song costs no more than seeking near its start, and
+ * never allocates. The frames rendered afterwards are identical to the
+ * same frames of a render from the start, so seeking and then rendering
+ * N frames renders the range [frame, frame + N).
+ */
+JshlStatus jshl_song_seek(JshlSong* song, long frame);
+
+/**
+ * @brief Returns the playback position of a song
+ * @param song Compiled song
+ * @return Next frame jshl_render_into will produce
+ */
+long jshl_song_position(const JshlSong* song);
+
+/**
+ * @brief Returns the length of a song
+ * @param song Compiled song
+ * @return Total frames, release tails and a 1 second tail included
+ */
+long jshl_song_frames(const JshlSong* song);
+
+/**
+ * @brief Returns the sample rate a song was compiled for
+ * @param song Compiled song
+ * @return Sample rate in Hz
+ */
+int jshl_song_sample_rate(const JshlSong* song);
+
+/**
+ * @brief Returns the number of notes of a song (loops expanded)
+ * @param song Compiled song
+ * @return Note count
+ */
+size_t jshl_song_note_count(const JshlSong* song);
+
+/**
+ * @brief Frees a song
+ * @param song Song to free (NULL is ignored)
+ */
+void jshl_song_free(JshlSong* song);
+
+/**
+ * @brief Describes a status
+ * @param status Status returned by a library call
+ * @return Static English message
+ */
+const char* jshl_status_string(JshlStatus status);
+
+#endif /* JSHL_H */
@@ -1,7 +1,8 @@
 #ifndef JSHL_COMPILER_H
 #define JSHL_COMPILER_H
 
-#include <stdint.h> // Para tipos de inteiros como uint16_t
+#include <stddef.h> // Para size_t
+#include <stdint.h> // Para tipos de inteiros como uint32_t
 
 // --- Configurações de Áudio ---
 #define SAMPLE_RATE 44100
@@ -34,6 +35,15 @@ typedef struct {
     float last_freq;
 } SynthState;
 
+// Formatos de saída de áudio
+typedef enum {
+    FORMAT_WAV,
+    FORMAT_RAW,
+    FORMAT_FLAC,
+    FORMAT_MP3,
+    FORMAT_UNKNOWN
+} OutputFormat;
+
 // Evento de nota, capturado durante o parsing
 typedef struct {
     float freq;
@@ -42,25 +52,52 @@ typedef struct {
     SynthState state; // Uma cópia do estado do sintetizador NO MOMENTO da nota
 } NoteEvent;
 
-// Lista dinâmica para armazenar as notas
+// Referência de estado por nota: índice na tabela de estados + bit de legato
+#define NOTE_STATE_LEGATO 0x80000000u   // last_freq = frequência da nota anterior
+#define NOTE_STATE_INDEX_MASK 0x7FFFFFFFu
+#define NOTE_STATE_MAX 0x80000000u      // Máximo de estados distintos
+
+// Lista dinâmica de notas em colunas (struct-of-arrays). Os estados do
+// sintetizador são deduplicados numa tabela; use note_list_get para
+// reconstruir um NoteEvent completo.
 typedef struct {
-    NoteEvent* notes;
+    float* freq;
+    float* duration;
+    float* start_time;
+    uint32_t* state;        // Referência de estado (ver NOTE_STATE_*)
     size_t size;
     size_t capacity;
+
+    SynthState* states;     // Estados distintos
+    size_t state_count;
+    size_t state_capacity;
+    uint32_t* state_slots;  // Tabela hash (endereçamento aberto) de índice + 1
+    size_t slot_count;
+
+    struct Arena* arena;    // Origem da memória (NULL = malloc)
 } NoteList;
 
+// Repetição de um bloco LOOP, registrada durante a avaliação
+typedef struct {
+    size_t first_note;      // Primeira nota da primeira iteração
+    size_t note_count;      // Notas geradas por iteração
+    int iterations;         // Número de repetições
+} LoopSpan;
+
+// Lista dinâmica de blocos LOOP avaliados
+typedef struct {
+    LoopSpan* spans;
+    size_t size;
+    size_t capacity;
+} LoopList;
+
 // --- Funções da Lista de Notas ---
-void note_list_init(NoteList* list);
-void note_list_add(NoteList* list, NoteEvent note);
+void note_list_get(const NoteList* list, size_t index, NoteEvent* note);
 void note_list_free(NoteList* list);
 
 // --- Funções do Compilador ---
-void parse_jshl(char* code, NoteList* list);
 float* render_audio(NoteList* list, long* total_samples);
 
-// --- Função de Escrita WAV ---
-void write_wav_file(const char* filename, float* buffer, long sample_count);
-
 // --- Função de Parsing de Notas ---
 float get_note_freq(const char* note_name);
 
@@ -0,0 +1,120 @@
+/**
+ * @file ir.h
+ * @brief Intermediate representation of parsed JSHL programs
+ * @author joaomrpimentel
+ * @version 1.3
+ */
+
+#ifndef IR_H
+#define IR_H
+
+#include <stdbool.h>
+#include <stdarg.h>
+#include "jshl_compiler.h"
+#include "arena.h"
+
+/**
+ * @brief Receives a parser diagnostic
+ * @param format printf-style message, including its "Warning:" prefix
+ * @param args Message arguments
+ */
+typedef void (*ProgramReport)(const char* format, va_list args);
+
+/** Returned by program_emit when the instruction could not be stored */
+#define PROGRAM_EMIT_FAILED ((size_t)-1)
+
+/**
+ * @brief Instruction opcodes
+ */
+typedef enum {
+    OP_WAVE,        /**< Set waveform */
+    OP_ENVELOPE,    /**< Set ADSR envelope */
+    OP_SLIDE,       /**< Set portamento time */
+    OP_PAUSE,       /**< Advance time, reset slide source */
+    OP_NOTE,        /**< Emit a note (frequency already resolved) */
+    OP_LOOP,        /**< Start of a repeated block */
+    OP_END_LOOP     /**< End of a repeated block */
+} OpCode;
+
+/**
+ * @brief Single IR instruction
+ */
+typedef struct {
+    OpCode op;
+    int line;                   /**< 1-based source line, for diagnostics */
+    union {
+        WaveType wave;          /**< OP_WAVE */
+        Envelope envelope;      /**< OP_ENVELOPE */
+        float seconds;          /**< OP_SLIDE, OP_PAUSE */
+        struct {
+            float freq;
+            float duration;
+        } note;                 /**< OP_NOTE */
+        struct {
+            int count;          /**< Repetitions */
+            size_t match;       /**< Index of the matching OP_LOOP / OP_END_LOOP */
+        } loop;                 /**< OP_LOOP, OP_END_LOOP */
+    } arg;
+} Instruction;
+
+/**
+ * @brief Compiled program: flat instruction array with matched loop pairs
+ */
+typedef struct {
+    Instruction* code;
+    size_t size;
+    size_t capacity;
+    int max_depth;              /**< Deepest LOOP nesting */
+    Arena* arena;               /**< Source of code and scratch memory (NULL = malloc) */
+    ProgramReport report;       /**< Called for each diagnostic (NULL = silent, the default) */
+    int warnings;               /**< Diagnostics raised while parsing */
+    int first_warning_line;     /**< Line of the first diagnostic (0 = none) */
+} Program;
+
+/**
+ * @brief Initializes an empty program allocating from an arena
+ * @param program Program to initialize
+ * @param arena Arena for the code and parser scratch (NULL to use malloc)
+ * @return 0 on success, -1 on allocation failure
+ */
+int program_init_arena(Program* program, Arena* arena);
+
+/**
+ * @brief Appends an instruction
+ * @param program Target program
+ * @param instruction Instruction to append
+ * @return Index of the new instruction, or PROGRAM_EMIT_FAILED on allocation failure
+ */
+size_t program_emit(Program* program, Instruction instruction);
+
+/**
+ * @brief Frees all memory associated with a program
+ * @param program Program to deallocate
+ */
+void program_free(Program* program);
+
+/**
+ * @brief Evaluates a program, expanding loops into note events
+ * @param program Compiled program
+ * @param list Output note list to populate
+ * @return 0 on success, -1 on allocation failure
+ *
+ * Runs from the default synthesizer state (SQUARE wave, envelope
+ * A=0.01s D=0s S=1.0 R=0.01s, no slide). Loops are evaluated by jumping
+ * back over the instruction array, so no source text is touched again.
+ */
+int program_execute(const Program* program, NoteList* list);
+
+/**
+ * @brief Evaluates a program and records where each loop's notes landed
+ * @param program Compiled program
+ * @param list Output note list to populate
+ * @param loops Output list of loop spans (NULL to skip recording)
+ * @return 0 on success, -1 on allocation failure
+ *
+ * A span is recorded when its loop finishes, so inner loops come before
+ * the loops enclosing them. Loops that emit no notes are not recorded.
+ */
+int program_execute_loops(const Program* program, NoteList* list, LoopList* loops);
+
+#endif /* IR_H */
@@ -0,0 +1,118 @@
+/**
+ * @file lexer.h
+ * @brief Line tokenizer working directly on the source bytes
+ * @author joaomrpimentel
+ * @version 1.0
+ */
+
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "jshl_compiler.h"
+
+/** Tokens kept per line; the longest command (ENVELOPE) needs 5 */
+#define LEXER_MAX_TOKENS 8
+
+/**
+ * @brief Slice of the source text
+ */
+typedef struct {
+    size_t offset;  /**< First byte in the source */
+    size_t length;  /**< Number of bytes */
+} Token;
+
+/**
+ * @brief Command keyword of a line
+ */
+typedef enum {
+    TOKEN_WORD,         /**< Not a keyword: a note name or an unknown word */
+    TOKEN_WAVE,
+    TOKEN_ENVELOPE,
+    TOKEN_SLIDE,
+    TOKEN_PAUSE,
+    TOKEN_LOOP,
+    TOKEN_CLOSE         /**< "}" */
+} TokenKind;
+
+/**
+ * @brief Tokenizer state
+ */
+typedef struct {
+    const char* src;    /**< Source bytes (need not be NUL-terminated) */
+    size_t size;        /**< Source length */
+    size_t pos;         /**< Start of the next line */
+    int line;           /**< 1-based number of the next line */
+} Lexer;
+
+/**
+ * @brief Starts tokenizing a buffer
+ * @param lexer Lexer to initialize
+ * @param src Source bytes
+ * @param size Source length
+ */
+void lexer_init(Lexer* lexer, const char* src, size_t size);
+
+/**
+ * @brief Splits the next meaningful line into tokens
+ * @param lexer Active lexer
+ * @param tokens Output tokens (at least LEXER_MAX_TOKENS entries)
+ * @param line Output 1-based line number
+ * @return Number of tokens (1..LEXER_MAX_TOKENS), or 0 at end of input
+ *
+ * Tokens are separated by spaces and tabs. A line ends at '\n' or at
+ * its first '\r'; blank lines and lines starting with '#' are skipped.
+ * Lines of any length are supported, extra tokens are ignored.
+ */
+int lexer_next_line(Lexer* lexer, Token* tokens, int* line);
+
+/**
+ * @brief Compares a token with a NUL-terminated word
+ * @param src Source bytes
+ * @param token Token to compare
+ * @param word Expected text
+ * @return true if the token is exactly word
+ */
+bool token_equals(const char* src, Token token, const char* word);
+
+/**
+ * @brief Classifies a command token
+ * @param src Source bytes
+ * @param token Token to classify
+ * @return Keyword kind, or TOKEN_WORD
+ *
+ * Uses a perfect hash over the keyword set followed by one comparison.
+ */
+TokenKind token_keyword(const char* src, Token token);
+
+/**
+ * @brief Parses a waveform name (SINE, SQUARE, SAWTOOTH, TRIANGLE)
+ * @param src Source bytes
+ * @param token Token to parse
+ * @param wave Output waveform
+ * @return true if the token names a waveform
+ */
+bool token_wave(const char* src, Token token, WaveType* wave);
+
+/**
+ * @brief Parses a token as a decimal number
+ * @param src Source bytes
+ * @param token Token to parse
+ * @return Value of the longest numeric prefix, as atof() would return
+ *
+ * Plain decimals (up to 19 significant digits, exponent within ±22) are
+ * converted exactly without the C library; anything else, including
+ * trailing garbage, inf, nan and hex floats, goes through strtod.
+ */
+float token_to_float(const char* src, Token token);
+
+/**
+ * @brief Parses a token as an integer
+ * @param src Source bytes
+ * @param token Token to parse
+ * @return Value of the longest integer prefix, as atoi() would return
+ */
+int token_to_int(const char* src, Token token);
+
+#endif /* LEXER_H */
@@ -2,25 +2,38 @@
  * @file parser.h
  * @brief JSHL language parser interface
  * @author joaomrpimentel
- * @version 1.0
+ * @version 1.3
  */
 
 #ifndef PARSER_H
 #define PARSER_H
 
 #include "jshl_compiler.h"
+#include "ir.h"
 
 /**
- * @brief Main entry point for JSHL source code parsing
+ * @brief Compiles JSHL source code to an IR program
  * @param code Null-terminated JSHL source code string
- * @param list Output note list to populate
- * 
- * Splits source into lines, initializes default synthesizer state,
- * and invokes recursive parser. Default state:
- * - Waveform: SQUARE
- * - Envelope: A=0.01s, D=0s, S=1.0, R=0.01s
- * - Slide: 0s (disabled)
+ * @param program Initialized program receiving the instructions
+ * @return 0 on success, -1 on allocation failure
+ *
+ * Parse time is linear in the source size: loop bodies are compiled once
+ * and only expanded when the program is executed (see program_execute).
  */
-void parse_jshl(char* code, NoteList* list);
+int parse_jshl_program(char* code, Program* program);
+
+/**
+ * @brief Compiles a JSHL source buffer to an IR program without copying it
+ * @param src Source bytes, e.g. a memory-mapped file (need not be NUL-terminated)
+ * @param size Source length in bytes
+ * @param program Initialized program receiving the instructions
+ * @return 0 on success, -1 on allocation failure
+ *
+ * Lines are tokenized in place (see lexer_next_line), so there is no
+ * limit on line length. Unknown notes, unmatched braces and unclosed
+ * loops are recovered from; they are counted in program->warnings and
+ * passed to program->report when it is set. Nothing is printed here.
+ */
+int parse_jshl_source(const char* src, size_t size, Program* program);
 
 #endif /* PARSER_H */
\ No newline at end of file
@@ -0,0 +1,190 @@
+/**
+ * @file jshl.c
+ * @brief Embeddable JSHL synthesizer (libjshl) implementation
+ * @author joaomrpimentel
+ * @version 1.2
+ */
+
+#include <stdlib.h>
+#include "jshl.h"
+#include "jshl_compiler.h"
+#include "arena.h"
+#include "source.h"
+#include "note_list.h"
+#include "parser.h"
+#include "synth.h"
+#include "dsp.h"
+
+/** Largest window handed to the synthesizer per step; the active voice
+ *  arrays are sized for it at compile time */
+#define JSHL_RENDER_BLOCK 4096
+
+struct JshlSong {
+    Arena arena;            /**< Owns the note list */
+    NoteList notes;
+    SynthStream stream;
+    int sample_rate;
+};
+
+void jshl_options_init(JshlOptions* options) {
+    options->sample_rate = SAMPLE_RATE;
+    options->note_phase = false;
+    options->draft = false;
+    options->strict = false;
+}
+
+/**
+ * @brief Expands a compiled program into a new song
+ * @param program Parsed program
+ * @param options Validated options
+ * @param song Output song
+ * @return JSHL_OK or an error status
+ */
+static JshlStatus song_create(const Program* program, const JshlOptions* options,
+                              JshlSong** song) {
+    JshlSong* created = (JshlSong*)calloc(1, sizeof(JshlSong));
+    if (!created) return JSHL_ERROR_RESOURCES;
+
+    arena_init(&created->arena, 0);
+    created->sample_rate = options->sample_rate;
+    if (note_list_init_arena(&created->notes, &created->arena) != 0 ||
+        program_execute_loops(program, &created->notes, NULL) != 0) {
+        arena_free(&created->arena);
+        free(created);
+        return JSHL_ERROR_RESOURCES;
+    }
+    if (created->notes.size == 0) {
+        arena_free(&created->arena);
+        free(created);
+        return JSHL_ERROR_EMPTY;
+    }
+
+    SynthOptions synth_options;
+    synth_options_init(&synth_options);
+    synth_options.phase = options->note_phase ? VOICE_PHASE_NOTE : VOICE_PHASE_GLOBAL;
+    synth_options.sample_rate = options->sample_rate;
+    synth_options.draft = options->draft;
+    if (synth_stream_init(&created->stream, &created->notes, &synth_options) != 0) {
+        arena_free(&created->arena);
+        free(created);
+        return JSHL_ERROR_RESOURCES;
+    }
+    if (synth_stream_reserve(&created->stream, JSHL_RENDER_BLOCK) != 0) {
+        jshl_song_free(created);
+        return JSHL_ERROR_RESOURCES;
+    }
+
+    // Kernel selection happens once per process; do it outside the render path
+    dsp_kernels();
+
+    *song = created;
+    return JSHL_OK;
+}
+
+JshlStatus jshl_song_compile(const char* source, size_t size, const JshlOptions* options,
+                             JshlSong** song, int* error_line) {
+    JshlOptions defaults;
+    if (!options) {
+        jshl_options_init(&defaults);
+        options = &defaults;
+    }
+    if (error_line) *error_line = 0;
+    if (!song || (!source && size > 0) ||
+        options->sample_rate < 8000 || options->sample_rate > 192000) {
+        return JSHL_ERROR_INVALID_ARGUMENT;
+    }
+
+    // The program is only needed until the notes are expanded
+    Arena scratch;
+    Program program;
+    arena_init(&scratch, 0);
+    if (program_init_arena(&program, &scratch) != 0) {
+        arena_free(&scratch);
+        return JSHL_ERROR_RESOURCES;
+    }
+
+    JshlStatus status = JSHL_OK;
+    if (parse_jshl_source(source, size, &program) != 0) {
+        status = JSHL_ERROR_RESOURCES;
+    } else {
+        if (error_line) *error_line = program.first_warning_line;
+        if (options->strict && program.warnings > 0) status = JSHL_ERROR_SYNTAX;
+        else status = song_create(&program, options, song);
+    }
+
+    arena_free(&scratch);
+    return status;
+}
+
+JshlStatus jshl_song_compile_file(const char* path, const JshlOptions* options,
+                                  JshlSong** song, int* error_line) {
+    if (error_line) *error_line = 0;
+    if (!path || !song) return JSHL_ERROR_INVALID_ARGUMENT;
+
+    Source source;
+    if (source_map(&source, path) != 0) return JSHL_ERROR_IO;
+
+    JshlStatus status = jshl_song_compile(source.data, source.size, options, song, error_line);
+    source_close(&source);
+    return status;
+}
+
+long jshl_render_into(JshlSong* song, float* out, long frames) {
+    if (!song || (!out && frames > 0) || frames < 0) return JSHL_ERROR_INVALID_ARGUMENT;
+
+    long done = 0;
+    while (done < frames) {
+        long block = frames - done < JSHL_RENDER_BLOCK ? frames - done : JSHL_RENDER_BLOCK;
+        long rendered = synth_stream_read(&song->stream, out + done, block);
+        if (rendered < 0) return JSHL_ERROR_RESOURCES;
+        if (rendered == 0) break;
+        done += rendered;
+    }
+    return done;
+}
+
+void jshl_song_rewind(JshlSong* song) {
+    if (song) synth_stream_rewind(&song->stream);
+}
+
+JshlStatus jshl_song_seek(JshlSong* song, long frame) {
+    if (!song || frame < 0) return JSHL_ERROR_INVALID_ARGUMENT;
+    if (synth_stream_seek(&song->stream, frame) != 0) return JSHL_ERROR_RESOURCES;
+    return JSHL_OK;
+}
+
+long jshl_song_position(const JshlSong* song) {
+    return song ? song->stream.position : 0;
+}
+
+long jshl_song_frames(const JshlSong* song) {
+    return song ? song->stream.total_samples : 0;
+}
+
+int jshl_song_sample_rate(const JshlSong* song) {
+    return song ? song->sample_rate : 0;
+}
+
+size_t jshl_song_note_count(const JshlSong* song) {
+    return song ? song->notes.size : 0;
+}
+
+void jshl_song_free(JshlSong* song) {
+    if (!song) return;
+
+    synth_stream_free(&song->stream);
+    arena_free(&song->arena);
+    free(song);
+}
+
+const char* jshl_status_string(JshlStatus status) {
+    switch (status) {
+        case JSHL_OK:                       return "Success";
+        case JSHL_ERROR_INVALID_ARGUMENT:   return "Invalid argument";
+        case JSHL_ERROR_RESOURCES:          return "Out of memory or song too large";
+        case JSHL_ERROR_IO:                 return "Cannot read source file";
+        case JSHL_ERROR_SYNTAX:             return "Syntax error";
+        case JSHL_ERROR_EMPTY:              return "Song has no notes";
+        default:                            return "Unknown error";
+    }
+}
@@ -0,0 +1,111 @@
+/**
+ * @file audio_writer.c
+ * @brief Format-independent incremental audio export implementation
+ * @author joaomrpimentel
+ * @version 1.2
+ */
+
+#include <stdio.h>
+#include "audio_writer.h"
+#include "wav_writer.h"
+#include "raw_writer.h"
+#include "flac_writer.h"
+#include "mp3_writer.h"
+
+void audio_writer_options_init(AudioWriterOptions* options) {
+    options->threads = 1;
+    options->pcm_format = PCM_FLOAT32;
+    options->dither = false;
+}
+
+int audio_writer_open(AudioWriter* writer, OutputFormat format,
+                      const char* filename, int sample_rate) {
+    return audio_writer_open_with_options(writer, format, filename, sample_rate, NULL);
+}
+
+int audio_writer_open_with_options(AudioWriter* writer, OutputFormat format,
+                                   const char* filename, int sample_rate,
+                                   const AudioWriterOptions* options) {
+    AudioWriterOptions defaults;
+    if (!options) {
+        audio_writer_options_init(&defaults);
+        options = &defaults;
+    }
+    bool pcm24 = options->pcm_format == PCM_INT24 && !options->dither;
+    writer->format = format;
+    writer->pcm24 = format == FORMAT_FLAC || ((format == FORMAT_WAV || format == FORMAT_RAW) && pcm24);
+
+    switch (format) {
+        case FORMAT_WAV:
+            writer->handle = wav_writer_open_format(filename, sample_rate,
+                                                    options->pcm_format, options->dither);
+            break;
+        case FORMAT_RAW:
+            writer->handle = raw_writer_open_format(filename, options->pcm_format, options->dither);
+            break;
+        case FORMAT_FLAC:
+            writer->handle = flac_writer_open_threads(filename, sample_rate, options->threads);
+            break;
+        case FORMAT_MP3:  writer->handle = mp3_writer_open(filename, sample_rate); break;
+        default:
+            fprintf(stderr, "Error: Unsupported output format\n");
+            writer->handle = NULL;
+            break;
+    }
+
+    return writer->handle ? 0 : -1;
+}
+
+int audio_writer_write(AudioWriter* writer, const float* samples, long count) {
+    switch (writer->format) {
+        case FORMAT_WAV:  return wav_writer_write(writer->handle, samples, count);
+        case FORMAT_RAW:  return raw_writer_write(writer->handle, samples, count);
+        case FORMAT_FLAC: return flac_writer_write(writer->handle, samples, count);
+        case FORMAT_MP3:  return mp3_writer_write(writer->handle, samples, count);
+        default:          return -1;
+    }
+}
+
+bool audio_writer_uses_pcm24(const AudioWriter* writer) {
+    return writer->pcm24;
+}
+
+int audio_writer_write_pcm24(AudioWriter* writer, const int32_t* pcm, long count) {
+    switch (writer->format) {
+        case FORMAT_WAV:  return wav_writer_write_pcm24(writer->handle, pcm, count);
+        case FORMAT_RAW:  return raw_writer_write_pcm24(writer->handle, pcm, count);
+        case FORMAT_FLAC: return flac_writer_write_pcm24(writer->handle, pcm, count);
+        default:          return -1;
+    }
+}
+
+int audio_writer_close(AudioWriter* writer) {
+    void* handle = writer->handle;
+    writer->handle = NULL;
+
+    switch (writer->format) {
+        case FORMAT_WAV:  return wav_writer_close(handle);
+        case FORMAT_RAW:  return raw_writer_close(handle);
+        case FORMAT_FLAC: return flac_writer_close(handle);
+        case FORMAT_MP3:  return mp3_writer_close(handle);
+        default:          return -1;
+    }
+}
+
+const char* audio_format_extension(OutputFormat format) {
+    switch (format) {
+        case FORMAT_WAV:  return "wav";
+        case FORMAT_RAW:  return "raw";
+        case FORMAT_FLAC: return "flac";
+        case FORMAT_MP3:  return "mp3";
+        default:          return "bin";
+    }
+}
+
+const char* audio_format_encoder_version(OutputFormat format) {
+    switch (format) {
+        case FORMAT_FLAC: return flac_writer_version();
+        case FORMAT_MP3:  return mp3_writer_version();
+        default:          return "";
+    }
+}
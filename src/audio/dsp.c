@@ -0,0 +1,119 @@
+/**
+ * @file dsp.c
+ * @brief Scalar DSP kernels and runtime CPU dispatch
+ * @author joaomrpimentel
+ * @version 1.1
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "dsp.h"
+#include "oscillator.h"
+
+static void mix_ramp_scalar(float* out, const float* src, int count,
+                            float level, float delta, int index, float gain) {
+    for (int i = 0; i < count; i++) {
+        out[i] += src[i] * (level + (float)(index + i) * delta) * gain;
+    }
+}
+
+static void clip_scalar(float* buffer, long count) {
+    for (long i = 0; i < count; i++) {
+        float sample = buffer[i];
+        sample = sample > 1.0f ? 1.0f : sample;
+        buffer[i] = sample < -1.0f ? -1.0f : sample;
+    }
+}
+
+static void float_to_int_scalar(const float* in, int32_t* out, long count, float scale) {
+    for (long i = 0; i < count; i++) {
+        float sample = in[i];
+        sample = sample > 1.0f ? 1.0f : sample;
+        sample = sample < -1.0f ? -1.0f : sample;
+        out[i] = (int32_t)(sample * scale);
+    }
+}
+
+static void float_to_int16_scalar(const float* in, int16_t* out, long count) {
+    for (long i = 0; i < count; i++) {
+        float sample = in[i];
+        sample = sample > 1.0f ? 1.0f : sample;
+        sample = sample < -1.0f ? -1.0f : sample;
+        out[i] = (int16_t)lrintf(sample * INT16_SCALE);
+    }
+}
+
+static void float_to_int24_scalar(const float* in, int32_t* out, long count) {
+    for (long i = 0; i < count; i++) {
+        float sample = in[i];
+        sample = sample > 1.0f ? 1.0f : sample;
+        sample = sample < -1.0f ? -1.0f : sample;
+        out[i] = (int32_t)lrintf(sample * INT24_SCALE);
+    }
+}
+
+const DspKernels dsp_scalar_kernels = {
+    "scalar",
+    osc_fill,
+    mix_ramp_scalar,
+    clip_scalar,
+    float_to_int_scalar,
+    float_to_int16_scalar,
+    float_to_int24_scalar
+};
+
+static const DspKernels* active_kernels = &dsp_scalar_kernels;
+static pthread_once_t dispatch_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Checks whether the running CPU can execute a kernel table
+ * @param kernels Candidate table
+ * @return Non-zero if the table is compiled in and supported
+ */
+static int kernels_supported(const DspKernels* kernels) {
+    if (!kernels->name) return 0;
+    if (kernels == &dsp_scalar_kernels) return 1;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (kernels == &dsp_avx2_kernels) return __builtin_cpu_supports("avx2");
+    if (kernels == &dsp_sse2_kernels) return __builtin_cpu_supports("sse2");
+#endif
+    return 0;
+}
+
+/**
+ * @brief Selects the kernel table once per process
+ */
+static void select_kernels(void) {
+    const DspKernels* candidates[] = { &dsp_avx2_kernels, &dsp_sse2_kernels };
+    const char* forced = getenv("JSHL_SIMD");
+
+    if (forced && strcmp(forced, "scalar") == 0) return;
+
+    for (size_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]); i++) {
+        if (forced && (!candidates[i]->name || strcmp(forced, candidates[i]->name) != 0)) {
+            continue;
+        }
+        if (kernels_supported(candidates[i])) {
+            active_kernels = candidates[i];
+            return;
+        }
+    }
+
+    // Forced choice not available: use the best supported one
+    if (forced) {
+        for (size_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]); i++) {
+            if (kernels_supported(candidates[i])) {
+                active_kernels = candidates[i];
+                return;
+            }
+        }
+    }
+}
+
+const DspKernels* dsp_kernels(void) {
+    pthread_once(&dispatch_once, select_kernels);
+    return active_kernels;
+}
@@ -0,0 +1,173 @@
+/**
+ * @file dsp_avx2.c
+ * @brief AVX2 DSP kernels (8 floats per instruction)
+ * @author joaomrpimentel
+ * @version 1.1
+ */
+
+#include "dsp.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#pragma GCC target("avx2")
+#include <immintrin.h>
+#include "oscillator.h"
+
+/** @brief Vector osc_wrap(): p - trunc(p) for non-negative p */
+static inline __m256 wrap_ps(__m256 p) {
+    return _mm256_sub_ps(p, _mm256_cvtepi32_ps(_mm256_cvttps_epi32(p)));
+}
+
+/** @brief 1.0f where p >= 0.5, 0.0f elsewhere */
+static inline __m256 half_ps(__m256 p) {
+    return _mm256_and_ps(_mm256_cmp_ps(p, _mm256_set1_ps(0.5f), _CMP_GE_OQ),
+                         _mm256_set1_ps(1.0f));
+}
+
+/** @brief Folded triangle, same operations as osc_wave_value() */
+static inline __m256 triangle_ps(__m256 p) {
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 q = _mm256_sub_ps(wrap_ps(_mm256_add_ps(p, _mm256_set1_ps(0.25f))),
+                             _mm256_set1_ps(0.5f));
+    return _mm256_sub_ps(_mm256_set1_ps(1.0f),
+                         _mm256_mul_ps(_mm256_set1_ps(4.0f), _mm256_and_ps(q, abs_mask)));
+}
+
+static inline __m256 sine_ps(__m256 p) {
+    __m256 x = _mm256_mul_ps(triangle_ps(p), _mm256_set1_ps(PI * 0.5f));
+    __m256 x2 = _mm256_mul_ps(x, x);
+    __m256 poly = _mm256_add_ps(_mm256_set1_ps(-1.0f / 5040.0f),
+                                _mm256_mul_ps(x2, _mm256_set1_ps(1.0f / 362880.0f)));
+    poly = _mm256_add_ps(_mm256_set1_ps(1.0f / 120.0f), _mm256_mul_ps(x2, poly));
+    poly = _mm256_add_ps(_mm256_set1_ps(-1.0f / 6.0f), _mm256_mul_ps(x2, poly));
+    poly = _mm256_add_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(x2, poly));
+    return _mm256_mul_ps(x, poly);
+}
+
+static inline __m256 square_ps(__m256 p) {
+    return _mm256_sub_ps(_mm256_set1_ps(1.0f),
+                         _mm256_mul_ps(_mm256_set1_ps(2.0f), half_ps(p)));
+}
+
+static inline __m256 sawtooth_ps(__m256 p) {
+    return _mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(2.0f), p),
+                         _mm256_mul_ps(_mm256_set1_ps(2.0f), half_ps(p)));
+}
+
+/** @brief Vector loop over phases phase + i * step, scalar tail */
+#define FILL_LOOP(wave_fn, wave_type)                                        \
+    for (; i + 8 <= count; i += 8) {                                          \
+        __m256 fi = _mm256_add_ps(_mm256_set1_ps((float)i), lane);            \
+        __m256 p = wrap_ps(_mm256_add_ps(vphase, _mm256_mul_ps(fi, vstep)));  \
+        _mm256_storeu_ps(out + i, wave_fn(p));                                \
+    }                                                                         \
+    for (; i < count; i++) {                                                  \
+        out[i] = osc_wave_value(wave_type, osc_wrap(phase + (float)i * step)); \
+    }
+
+static void osc_fill_avx2(WaveType wave, float phase, float step, float* out, int count) {
+    const __m256 lane = _mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f);
+    const __m256 vphase = _mm256_set1_ps(phase);
+    const __m256 vstep = _mm256_set1_ps(step);
+    int i = 0;
+
+    switch (wave) {
+        case WAVE_SINE:     FILL_LOOP(sine_ps, WAVE_SINE); break;
+        case WAVE_SQUARE:   FILL_LOOP(square_ps, WAVE_SQUARE); break;
+        case WAVE_SAWTOOTH: FILL_LOOP(sawtooth_ps, WAVE_SAWTOOTH); break;
+        case WAVE_TRIANGLE: FILL_LOOP(triangle_ps, WAVE_TRIANGLE); break;
+        default:            osc_fill(wave, phase, step, out, count); break;
+    }
+}
+
+static void mix_ramp_avx2(float* out, const float* src, int count,
+                          float level, float delta, int index, float gain) {
+    const __m256 lane = _mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f);
+    const __m256 vlevel = _mm256_set1_ps(level);
+    const __m256 vdelta = _mm256_set1_ps(delta);
+    const __m256 vgain = _mm256_set1_ps(gain);
+    int i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 fi = _mm256_add_ps(_mm256_set1_ps((float)(index + i)), lane);
+        __m256 env = _mm256_add_ps(vlevel, _mm256_mul_ps(fi, vdelta));
+        __m256 mixed = _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i), env), vgain);
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), mixed));
+    }
+    for (; i < count; i++) {
+        out[i] += src[i] * (level + (float)(index + i) * delta) * gain;
+    }
+}
+
+static void clip_avx2(float* buffer, long count) {
+    const __m256 hi = _mm256_set1_ps(1.0f);
+    const __m256 lo = _mm256_set1_ps(-1.0f);
+    long i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(buffer + i);
+        _mm256_storeu_ps(buffer + i, _mm256_max_ps(_mm256_min_ps(x, hi), lo));
+    }
+    dsp_scalar_kernels.clip(buffer + i, count - i);
+}
+
+static void float_to_int_avx2(const float* in, int32_t* out, long count, float scale) {
+    const __m256 hi = _mm256_set1_ps(1.0f);
+    const __m256 lo = _mm256_set1_ps(-1.0f);
+    const __m256 vscale = _mm256_set1_ps(scale);
+    long i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_max_ps(_mm256_min_ps(_mm256_loadu_ps(in + i), hi), lo);
+        _mm256_storeu_si256((__m256i*)(out + i),
+                            _mm256_cvttps_epi32(_mm256_mul_ps(x, vscale)));
+    }
+    dsp_scalar_kernels.float_to_int(in + i, out + i, count - i, scale);
+}
+
+static void float_to_int16_avx2(const float* in, int16_t* out, long count) {
+    const __m256 hi = _mm256_set1_ps(1.0f);
+    const __m256 lo = _mm256_set1_ps(-1.0f);
+    const __m256 vscale = _mm256_set1_ps(INT16_SCALE);
+    long i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m256 a = _mm256_max_ps(_mm256_min_ps(_mm256_loadu_ps(in + i), hi), lo);
+        __m256 b = _mm256_max_ps(_mm256_min_ps(_mm256_loadu_ps(in + i + 8), hi), lo);
+        __m256i ia = _mm256_cvtps_epi32(_mm256_mul_ps(a, vscale));
+        __m256i ib = _mm256_cvtps_epi32(_mm256_mul_ps(b, vscale));
+        // packs works per 128-bit lane: restore sample order afterwards
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(ia, ib), 0xD8);
+        _mm256_storeu_si256((__m256i*)(out + i), packed);
+    }
+    dsp_scalar_kernels.float_to_int16(in + i, out + i, count - i);
+}
+
+static void float_to_int24_avx2(const float* in, int32_t* out, long count) {
+    const __m256 hi = _mm256_set1_ps(1.0f);
+    const __m256 lo = _mm256_set1_ps(-1.0f);
+    const __m256 vscale = _mm256_set1_ps(INT24_SCALE);
+    long i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_max_ps(_mm256_min_ps(_mm256_loadu_ps(in + i), hi), lo);
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_cvtps_epi32(_mm256_mul_ps(x, vscale)));
+    }
+    dsp_scalar_kernels.float_to_int24(in + i, out + i, count - i);
+}
+
+const DspKernels dsp_avx2_kernels = {
+    "avx2",
+    osc_fill_avx2,
+    mix_ramp_avx2,
+    clip_avx2,
+    float_to_int_avx2,
+    float_to_int16_avx2,
+    float_to_int24_avx2
+};
+
+#else
+
+const DspKernels dsp_avx2_kernels = { NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+
+#endif
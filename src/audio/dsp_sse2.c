@@ -0,0 +1,167 @@
+/**
+ * @file dsp_sse2.c
+ * @brief SSE2 DSP kernels (4 floats per instruction)
+ * @author joaomrpimentel
+ * @version 1.1
+ */
+
+#include "dsp.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#pragma GCC target("sse2")
+#include <emmintrin.h>
+#include "oscillator.h"
+
+/** @brief Vector osc_wrap(): p - trunc(p) for non-negative p */
+static inline __m128 wrap_ps(__m128 p) {
+    return _mm_sub_ps(p, _mm_cvtepi32_ps(_mm_cvttps_epi32(p)));
+}
+
+/** @brief 1.0f where p >= 0.5, 0.0f elsewhere */
+static inline __m128 half_ps(__m128 p) {
+    return _mm_and_ps(_mm_cmpge_ps(p, _mm_set1_ps(0.5f)), _mm_set1_ps(1.0f));
+}
+
+/** @brief Folded triangle, same operations as osc_wave_value() */
+static inline __m128 triangle_ps(__m128 p) {
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 q = _mm_sub_ps(wrap_ps(_mm_add_ps(p, _mm_set1_ps(0.25f))), _mm_set1_ps(0.5f));
+    return _mm_sub_ps(_mm_set1_ps(1.0f),
+                      _mm_mul_ps(_mm_set1_ps(4.0f), _mm_and_ps(q, abs_mask)));
+}
+
+static inline __m128 sine_ps(__m128 p) {
+    __m128 x = _mm_mul_ps(triangle_ps(p), _mm_set1_ps(PI * 0.5f));
+    __m128 x2 = _mm_mul_ps(x, x);
+    __m128 poly = _mm_add_ps(_mm_set1_ps(-1.0f / 5040.0f),
+                             _mm_mul_ps(x2, _mm_set1_ps(1.0f / 362880.0f)));
+    poly = _mm_add_ps(_mm_set1_ps(1.0f / 120.0f), _mm_mul_ps(x2, poly));
+    poly = _mm_add_ps(_mm_set1_ps(-1.0f / 6.0f), _mm_mul_ps(x2, poly));
+    poly = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(x2, poly));
+    return _mm_mul_ps(x, poly);
+}
+
+static inline __m128 square_ps(__m128 p) {
+    return _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(2.0f), half_ps(p)));
+}
+
+static inline __m128 sawtooth_ps(__m128 p) {
+    return _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(2.0f), p),
+                      _mm_mul_ps(_mm_set1_ps(2.0f), half_ps(p)));
+}
+
+/** @brief Vector loop over phases phase + i * step, scalar tail */
+#define FILL_LOOP(wave_fn, wave_type)                                        \
+    for (; i + 4 <= count; i += 4) {                                          \
+        __m128 fi = _mm_add_ps(_mm_set1_ps((float)i), lane);                  \
+        __m128 p = wrap_ps(_mm_add_ps(vphase, _mm_mul_ps(fi, vstep)));         \
+        _mm_storeu_ps(out + i, wave_fn(p));                                   \
+    }                                                                         \
+    for (; i < count; i++) {                                                  \
+        out[i] = osc_wave_value(wave_type, osc_wrap(phase + (float)i * step)); \
+    }
+
+static void osc_fill_sse2(WaveType wave, float phase, float step, float* out, int count) {
+    const __m128 lane = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    const __m128 vphase = _mm_set1_ps(phase);
+    const __m128 vstep = _mm_set1_ps(step);
+    int i = 0;
+
+    switch (wave) {
+        case WAVE_SINE:     FILL_LOOP(sine_ps, WAVE_SINE); break;
+        case WAVE_SQUARE:   FILL_LOOP(square_ps, WAVE_SQUARE); break;
+        case WAVE_SAWTOOTH: FILL_LOOP(sawtooth_ps, WAVE_SAWTOOTH); break;
+        case WAVE_TRIANGLE: FILL_LOOP(triangle_ps, WAVE_TRIANGLE); break;
+        default:            osc_fill(wave, phase, step, out, count); break;
+    }
+}
+
+static void mix_ramp_sse2(float* out, const float* src, int count,
+                          float level, float delta, int index, float gain) {
+    const __m128 lane = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    const __m128 vlevel = _mm_set1_ps(level);
+    const __m128 vdelta = _mm_set1_ps(delta);
+    const __m128 vgain = _mm_set1_ps(gain);
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 fi = _mm_add_ps(_mm_set1_ps((float)(index + i)), lane);
+        __m128 env = _mm_add_ps(vlevel, _mm_mul_ps(fi, vdelta));
+        __m128 mixed = _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(src + i), env), vgain);
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), mixed));
+    }
+    for (; i < count; i++) {
+        out[i] += src[i] * (level + (float)(index + i) * delta) * gain;
+    }
+}
+
+static void clip_sse2(float* buffer, long count) {
+    const __m128 hi = _mm_set1_ps(1.0f);
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    long i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(buffer + i);
+        _mm_storeu_ps(buffer + i, _mm_max_ps(_mm_min_ps(x, hi), lo));
+    }
+    dsp_scalar_kernels.clip(buffer + i, count - i);
+}
+
+static void float_to_int_sse2(const float* in, int32_t* out, long count, float scale) {
+    const __m128 hi = _mm_set1_ps(1.0f);
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    const __m128 vscale = _mm_set1_ps(scale);
+    long i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(in + i), hi), lo);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_cvttps_epi32(_mm_mul_ps(x, vscale)));
+    }
+    dsp_scalar_kernels.float_to_int(in + i, out + i, count - i, scale);
+}
+
+static void float_to_int16_sse2(const float* in, int16_t* out, long count) {
+    const __m128 hi = _mm_set1_ps(1.0f);
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    const __m128 vscale = _mm_set1_ps(INT16_SCALE);
+    long i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128 a = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(in + i), hi), lo);
+        __m128 b = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(in + i + 4), hi), lo);
+        __m128i ia = _mm_cvtps_epi32(_mm_mul_ps(a, vscale));
+        __m128i ib = _mm_cvtps_epi32(_mm_mul_ps(b, vscale));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(ia, ib));
+    }
+    dsp_scalar_kernels.float_to_int16(in + i, out + i, count - i);
+}
+
+static void float_to_int24_sse2(const float* in, int32_t* out, long count) {
+    const __m128 hi = _mm_set1_ps(1.0f);
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    const __m128 vscale = _mm_set1_ps(INT24_SCALE);
+    long i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(in + i), hi), lo);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_cvtps_epi32(_mm_mul_ps(x, vscale)));
+    }
+    dsp_scalar_kernels.float_to_int24(in + i, out + i, count - i);
+}
+
+const DspKernels dsp_sse2_kernels = {
+    "sse2",
+    osc_fill_sse2,
+    mix_ramp_sse2,
+    clip_sse2,
+    float_to_int_sse2,
+    float_to_int16_sse2,
+    float_to_int24_sse2
+};
+
+#else
+
+const DspKernels dsp_sse2_kernels = { NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+
+#endif
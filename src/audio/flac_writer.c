@@ -2,113 +2,178 @@
  * @file flac_writer.c
  * @brief FLAC file export implementation using libFLAC
  * @author joaomrpimentel
- * @version 1.0
+ * @version 1.4
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <FLAC/export.h>
+#include <FLAC/format.h>
 #include <FLAC/stream_encoder.h>
 #include "flac_writer.h"
+#include "dsp.h"
+#include "thread_pool.h"
+
+/** Samples converted and handed to libFLAC per call and encoder thread */
+#define FLAC_CHUNK_SIZE 4096
+
+/** Largest conversion buffer, in samples */
+#define FLAC_MAX_CHUNK_SIZE 65536
+
+struct FlacWriter {
+    FLAC__StreamEncoder* encoder;
+    FLAC__int32* pcm;
+    long pcm_size;
+    int error;
+};
 
 /**
- * @brief Converts float samples to 24-bit integer samples
- * @param float_buffer Input float buffer [-1.0, 1.0]
- * @param int_buffer Output 32-bit integer buffer (24-bit precision)
- * @param sample_count Number of samples to convert
+ * @brief Asks libFLAC to encode frames on several threads
+ * @param encoder Encoder not yet initialized
+ * @param threads Requested thread count (> 1)
+ * @return Threads granted (1 if libFLAC cannot encode in parallel)
+ *
+ * libFLAC 1.5 (API 14) encodes independent frames on worker threads and
+ * produces the same stream as a serial encoder, STREAMINFO and MD5
+ * included. Older versions, or builds without threading, stay serial.
  */
-static void float_to_int24(const float* float_buffer, FLAC__int32* int_buffer, 
-                          long sample_count) {
-    const float scale = 8388607.0f;  // 2^23 - 1 (24-bit max)
-    
-    for (long i = 0; i < sample_count; i++) {
-        float sample = float_buffer[i];
-        
-        // Clamp to [-1.0, 1.0]
-        if (sample > 1.0f) sample = 1.0f;
-        if (sample < -1.0f) sample = -1.0f;
-        
-        // Scale to 24-bit integer range
-        int_buffer[i] = (FLAC__int32)(sample * scale);
-    }
+static int flac_set_threads(FLAC__StreamEncoder* encoder, int threads) {
+#if defined(FLAC_API_VERSION_CURRENT) && FLAC_API_VERSION_CURRENT >= 14
+    if (FLAC__stream_encoder_set_num_threads(encoder, (uint32_t)threads) == 0) return threads;
+#else
+    (void)encoder;
+    (void)threads;
+#endif
+    return 1;
 }
 
-int write_flac_file(const char* filename, float* buffer, long sample_count, int sample_rate) {
-    FLAC__StreamEncoder* encoder = NULL;
-    FLAC__int32* int_buffer = NULL;
-    int status = 0;
-    
-    // Allocate integer buffer for conversion
-    int_buffer = (FLAC__int32*)malloc(sample_count * sizeof(FLAC__int32));
-    if (!int_buffer) {
+FlacWriter* flac_writer_open(const char* filename, int sample_rate) {
+    return flac_writer_open_threads(filename, sample_rate, 1);
+}
+
+FlacWriter* flac_writer_open_threads(const char* filename, int sample_rate, int threads) {
+    if (threads < 1) threads = thread_pool_cpu_count();
+
+    FlacWriter* writer = (FlacWriter*)calloc(1, sizeof(FlacWriter));
+    if (!writer) {
         fprintf(stderr, "Error: Failed to allocate conversion buffer\n");
-        return -1;
+        return NULL;
     }
-    
-    // Convert float to 24-bit integer
-    float_to_int24(buffer, int_buffer, sample_count);
-    
+
     // Create encoder
-    encoder = FLAC__stream_encoder_new();
-    if (!encoder) {
+    writer->encoder = FLAC__stream_encoder_new();
+    if (!writer->encoder) {
         fprintf(stderr, "Error: Failed to create FLAC encoder\n");
-        free(int_buffer);
-        return -1;
+        free(writer);
+        return NULL;
     }
     
     // Configure encoder
-    FLAC__stream_encoder_set_channels(encoder, 1);              // Mono
-    FLAC__stream_encoder_set_bits_per_sample(encoder, 24);     // 24-bit
-    FLAC__stream_encoder_set_sample_rate(encoder, sample_rate);
-    FLAC__stream_encoder_set_compression_level(encoder, 8);    // Max compression
-    FLAC__stream_encoder_set_total_samples_estimate(encoder, sample_count);
+    FLAC__stream_encoder_set_channels(writer->encoder, 1);              // Mono
+    FLAC__stream_encoder_set_bits_per_sample(writer->encoder, 24);     // 24-bit
+    FLAC__stream_encoder_set_sample_rate(writer->encoder, sample_rate);
+    FLAC__stream_encoder_set_compression_level(writer->encoder, 8);    // Max compression
+    if (threads > 1) threads = flac_set_threads(writer->encoder, threads);
+
+    // Hand every encoder thread a frame per call
+    writer->pcm_size = (long)FLAC_CHUNK_SIZE * threads;
+    if (writer->pcm_size > FLAC_MAX_CHUNK_SIZE) writer->pcm_size = FLAC_MAX_CHUNK_SIZE;
+    writer->pcm = (FLAC__int32*)malloc(writer->pcm_size * sizeof(FLAC__int32));
+    if (!writer->pcm) {
+        fprintf(stderr, "Error: Failed to allocate conversion buffer\n");
+        FLAC__stream_encoder_delete(writer->encoder);
+        free(writer);
+        return NULL;
+    }
     
     // Initialize encoder
     FLAC__StreamEncoderInitStatus init_status = 
-        FLAC__stream_encoder_init_file(encoder, filename, NULL, NULL);
+        FLAC__stream_encoder_init_file(writer->encoder, filename, NULL, NULL);
     
     if (init_status != FLAC__STREAM_ENCODER_INIT_STATUS_OK) {
         fprintf(stderr, "Error: FLAC encoder initialization failed: %s\n",
                 FLAC__StreamEncoderInitStatusString[init_status]);
-        FLAC__stream_encoder_delete(encoder);
-        free(int_buffer);
-        return -1;
+        FLAC__stream_encoder_delete(writer->encoder);
+        free(writer->pcm);
+        free(writer);
+        return NULL;
     }
-    
-    // Encode audio in chunks
-    const int chunk_size = 4096;
+
+    return writer;
+}
+
+int flac_writer_write(FlacWriter* writer, const float* samples, long count) {
     long samples_encoded = 0;
-    
-    while (samples_encoded < sample_count) {
-        int samples_to_encode = (sample_count - samples_encoded < chunk_size)
-                               ? (sample_count - samples_encoded)
-                               : chunk_size;
-        
+
+    // Convert and encode audio in chunks
+    while (samples_encoded < count) {
+        int samples_to_encode = (count - samples_encoded < writer->pcm_size)
+                               ? (int)(count - samples_encoded)
+                               : (int)writer->pcm_size;
+
+        // Convert float to 24-bit integer (clamped to [-1.0, 1.0])
+        dsp_kernels()->float_to_int(samples + samples_encoded, writer->pcm,
+                                    samples_to_encode, INT24_SCALE);
+
         FLAC__bool encode_ok = FLAC__stream_encoder_process_interleaved(
-            encoder,
-            int_buffer + samples_encoded,
+            writer->encoder,
+            writer->pcm,
             samples_to_encode
         );
         
         if (!encode_ok) {
             fprintf(stderr, "Error: FLAC encoding failed\n");
-            status = -1;
-            break;
+            writer->error = 1;
+            return -1;
         }
         
         samples_encoded += samples_to_encode;
     }
-    
+
+    return 0;
+}
+
+int flac_writer_write_pcm24(FlacWriter* writer, const int32_t* pcm, long count) {
+    if (count > 0 && !FLAC__stream_encoder_process_interleaved(writer->encoder, pcm,
+                                                               (unsigned)count)) {
+        fprintf(stderr, "Error: FLAC encoding failed\n");
+        writer->error = 1;
+        return -1;
+    }
+    return 0;
+}
+
+int flac_writer_close(FlacWriter* writer) {
+    if (!writer) return 0;
+
+    int status = writer->error ? -1 : 0;
+
     // Finalize encoding
     if (status == 0) {
-        if (!FLAC__stream_encoder_finish(encoder)) {
+        if (!FLAC__stream_encoder_finish(writer->encoder)) {
             fprintf(stderr, "Error: Failed to finalize FLAC file\n");
             status = -1;
         }
     }
     
     // Cleanup
-    FLAC__stream_encoder_delete(encoder);
-    free(int_buffer);
+    FLAC__stream_encoder_delete(writer->encoder);
+    free(writer->pcm);
+    free(writer);
     
     return status;
-}
\ No newline at end of file
+}
+
+int write_flac_file(const char* filename, float* buffer, long sample_count, int sample_rate) {
+    FlacWriter* writer = flac_writer_open(filename, sample_rate);
+    if (!writer) return -1;
+
+    int status = flac_writer_write(writer, buffer, sample_count);
+    if (flac_writer_close(writer) != 0) status = -1;
+
+    return status;
+}
+
+const char* flac_writer_version(void) {
+    return FLAC__VERSION_STRING;
+}
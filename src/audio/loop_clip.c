@@ -0,0 +1,202 @@
+/**
+ * @file loop_clip.c
+ * @brief Pre-rendered LOOP iterations mixed at each repetition's offset
+ * @author joaomrpimentel
+ * @version 1.1
+ */
+
+#include <stdlib.h>
+#include "loop_clip.h"
+#include "note_list.h"
+
+/** Distinct sample layouts tried per loop before giving up on an iteration */
+#define LOOP_CLIP_MAX_VARIANTS 16
+
+/**
+ * @brief Prepares the voice of one note in the list
+ */
+static void note_voice(Voice* voice, const NoteList* list, size_t index,
+                       VoicePhase phase, int sample_rate, bool draft) {
+    NoteEvent note;
+    note_list_get(list, index, &note);
+    voice_init(voice, &note, sample_rate, phase);
+    if (draft) voice_use_draft_oscillator(voice);
+}
+
+/**
+ * @brief Orders spans by first note, enclosing loops before nested ones
+ */
+static int compare_spans(const void* a, const void* b) {
+    const LoopSpan* sa = (const LoopSpan*)a;
+    const LoopSpan* sb = (const LoopSpan*)b;
+    if (sa->first_note != sb->first_note) return sa->first_note < sb->first_note ? -1 : 1;
+
+    size_t na = sa->note_count * (size_t)sa->iterations;
+    size_t nb = sb->note_count * (size_t)sb->iterations;
+    if (na != nb) return na > nb ? -1 : 1;
+    return 0;
+}
+
+/**
+ * @brief Checks whether an iteration sounds exactly like the template
+ * @param list Note list
+ * @param tmpl First note of the template iteration
+ * @param first First note of the candidate iteration
+ * @param count Notes per iteration
+ * @param phase Phase policy
+ * @param sample_rate Sample rate in Hz
+ * @param draft Use draft oscillators
+ * @return true if the candidate can be replaced by the template's clip
+ */
+static bool iteration_matches(const NoteList* list, size_t tmpl, size_t first, size_t count,
+                              VoicePhase phase, int sample_rate, bool draft) {
+    Voice anchor_t, anchor_c;
+    note_voice(&anchor_t, list, tmpl, phase, sample_rate, draft);
+    note_voice(&anchor_c, list, first, phase, sample_rate, draft);
+
+    for (size_t k = 0; k < count; k++) {
+        Voice t, c;
+        note_voice(&t, list, tmpl + k, phase, sample_rate, draft);
+        note_voice(&c, list, first + k, phase, sample_rate, draft);
+        if (!voice_same_shape(&t, &c)) return false;
+        if (t.start - anchor_t.start != c.start - anchor_c.start) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Renders the template iteration into a new clip
+ * @return 0 on success, -1 on allocation failure
+ */
+static int render_clip(LoopClip* clip, const NoteList* list, size_t first, size_t count,
+                       VoicePhase phase, int sample_rate, bool draft) {
+    Voice voice;
+    note_voice(&voice, list, first, phase, sample_rate, draft);
+    long anchor = voice.start;
+    long end = anchor;
+
+    for (size_t k = 0; k < count; k++) {
+        note_voice(&voice, list, first + k, phase, sample_rate, draft);
+        if (voice.start + voice.length > end) end = voice.start + voice.length;
+    }
+
+    clip->length = end - anchor;
+    clip->samples = (float*)calloc(clip->length > 0 ? clip->length : 1, sizeof(float));
+    if (!clip->samples) return -1;
+
+    for (size_t k = 0; k < count; k++) {
+        note_voice(&voice, list, first + k, phase, sample_rate, draft);
+        voice_render(&voice, clip->samples, anchor, end);
+    }
+    return 0;
+}
+
+int loop_clips_build(LoopClipSet* set, const NoteList* list, const LoopList* loops,
+                     VoicePhase phase, int sample_rate, bool draft) {
+    set->clips = NULL;
+    set->clip_count = 0;
+    set->instances = NULL;
+    set->instance_count = 0;
+    if (!loops || loops->size == 0 || list->size == 0) return 0;
+
+    LoopSpan* spans = (LoopSpan*)malloc(loops->size * sizeof(LoopSpan));
+    set->clips = (LoopClip*)malloc(loops->size * LOOP_CLIP_MAX_VARIANTS * sizeof(LoopClip));
+    set->instances = (ClipInstance*)malloc(list->size * sizeof(ClipInstance));
+    if (!spans || !set->clips || !set->instances) {
+        free(spans);
+        loop_clips_free(set);
+        return -1;
+    }
+    for (size_t s = 0; s < loops->size; s++) spans[s] = loops->spans[s];
+    qsort(spans, loops->size, sizeof(LoopSpan), compare_spans);
+
+    size_t covered_end = 0;     // Notes before this index already belong to a clip
+    for (size_t s = 0; s < loops->size; s++) {
+        const LoopSpan* span = &spans[s];
+        if (span->iterations < 2 || span->note_count == 0) continue;
+        if (span->first_note < covered_end) continue;
+
+        // Start times accumulate in float, so iterations can land a sample
+        // apart; each distinct layout becomes its own variant
+        size_t variants[LOOP_CLIP_MAX_VARIANTS];
+        size_t matches[LOOP_CLIP_MAX_VARIANTS];
+        size_t variant_count = 0;
+        size_t first_instance = set->instance_count;
+
+        for (int it = 0; it < span->iterations; it++) {
+            size_t first = span->first_note + (size_t)it * span->note_count;
+            size_t v = 0;
+            while (v < variant_count &&
+                   !iteration_matches(list, variants[v], first, span->note_count,
+                                      phase, sample_rate, draft)) {
+                v++;
+            }
+            if (v == variant_count) {
+                if (variant_count == LOOP_CLIP_MAX_VARIANTS) continue;
+                variants[variant_count] = first;
+                matches[variant_count] = 0;
+                variant_count++;
+            }
+            matches[v]++;
+
+            Voice anchor;
+            note_voice(&anchor, list, first, phase, sample_rate, draft);
+
+            ClipInstance* instance = &set->instances[set->instance_count++];
+            instance->first_note = first;
+            instance->note_count = span->note_count;
+            instance->anchor = anchor.start;
+            instance->clip = v;     // Variant index until clips are rendered
+        }
+
+        // A clip played once saves nothing: render only shared variants
+        size_t clip_index[LOOP_CLIP_MAX_VARIANTS];
+        for (size_t v = 0; v < variant_count; v++) {
+            if (matches[v] < 2) continue;
+            if (render_clip(&set->clips[set->clip_count], list, variants[v],
+                            span->note_count, phase, sample_rate, draft) != 0) {
+                free(spans);
+                loop_clips_free(set);
+                return -1;
+            }
+            clip_index[v] = set->clip_count++;
+        }
+
+        size_t kept = first_instance;
+        for (size_t i = first_instance; i < set->instance_count; i++) {
+            ClipInstance instance = set->instances[i];
+            if (matches[instance.clip] < 2) continue;
+            instance.clip = clip_index[instance.clip];
+            set->instances[kept++] = instance;
+        }
+        set->instance_count = kept;
+
+        if (kept > first_instance) {
+            covered_end = span->first_note + span->note_count * (size_t)span->iterations;
+        }
+    }
+
+    free(spans);
+    return 0;
+}
+
+void loop_clip_mix(const LoopClip* clip, long anchor, float* out, long from, long to) {
+    long begin = anchor > from ? anchor : from;
+    long end = anchor + clip->length < to ? anchor + clip->length : to;
+
+    for (long i = begin; i < end; i++) {
+        out[i - from] += clip->samples[i - anchor];
+    }
+}
+
+void loop_clips_free(LoopClipSet* set) {
+    for (size_t c = 0; c < set->clip_count; c++) {
+        free(set->clips[c].samples);
+    }
+    free(set->clips);
+    free(set->instances);
+    set->clips = NULL;
+    set->clip_count = 0;
+    set->instances = NULL;
+    set->instance_count = 0;
+}
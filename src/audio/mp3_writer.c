@@ -2,7 +2,7 @@
  * @file mp3_writer.c
  * @brief MP3 file export implementation using LAME
  * @author joaomrpimentel
- * @version 1.0
+ * @version 1.3
  */
 
 #include <stdio.h>
@@ -10,90 +10,126 @@
 #include <lame/lame.h>
 #include "mp3_writer.h"
 
-int write_mp3_file(const char* filename, float* buffer, long sample_count, int sample_rate) {
-    FILE* fp = fopen(filename, "wb");
-    if (!fp) {
+/** Samples handed to LAME per call: eight MPEG-1 Layer III frames */
+#define MP3_CHUNK_SIZE (8 * 1152)
+
+/** Worst-case encoder output for one chunk, as documented by LAME */
+#define MP3_BUFFER_SIZE (MP3_CHUNK_SIZE * 5 / 4 + 7200)
+
+struct Mp3Writer {
+    FILE* fp;
+    lame_t lame;
+    unsigned char mp3_buffer[MP3_BUFFER_SIZE];
+    int error;
+};
+
+Mp3Writer* mp3_writer_open(const char* filename, int sample_rate) {
+    Mp3Writer* writer = (Mp3Writer*)calloc(1, sizeof(Mp3Writer));
+    if (!writer) {
+        fprintf(stderr, "Error: Failed to allocate MP3 buffer\n");
+        return NULL;
+    }
+
+    writer->fp = fopen(filename, "wb");
+    if (!writer->fp) {
         fprintf(stderr, "Error: Cannot write to file '%s'\n", filename);
-        return -1;
+        free(writer);
+        return NULL;
     }
-    
+
     // Initialize LAME encoder
-    lame_t lame = lame_init();
-    if (!lame) {
+    writer->lame = lame_init();
+    if (!writer->lame) {
         fprintf(stderr, "Error: Failed to initialize LAME encoder\n");
-        fclose(fp);
-        return -1;
+        fclose(writer->fp);
+        free(writer);
+        return NULL;
     }
-    
+
     // Configure encoder
-    lame_set_in_samplerate(lame, sample_rate);
-    lame_set_num_channels(lame, 1);  // Mono
-    lame_set_mode(lame, MONO);
-    lame_set_brate(lame, 320);       // 320 kbps CBR
-    lame_set_quality(lame, 2);       // High quality (0=best, 9=worst)
-    
-    if (lame_init_params(lame) < 0) {
+    lame_set_in_samplerate(writer->lame, sample_rate);
+    lame_set_num_channels(writer->lame, 1);  // Mono
+    lame_set_mode(writer->lame, MONO);
+    lame_set_brate(writer->lame, 320);       // 320 kbps CBR
+    lame_set_quality(writer->lame, 2);       // High quality (0=best, 9=worst)
+
+    if (lame_init_params(writer->lame) < 0) {
         fprintf(stderr, "Error: Failed to set LAME parameters\n");
-        lame_close(lame);
-        fclose(fp);
-        return -1;
-    }
-    
-    // Allocate MP3 output buffer (conservative size estimate)
-    size_t mp3_buffer_size = sample_count * 5 / 4 + 7200;
-    unsigned char* mp3_buffer = (unsigned char*)malloc(mp3_buffer_size);
-    if (!mp3_buffer) {
-        fprintf(stderr, "Error: Failed to allocate MP3 buffer\n");
-        lame_close(lame);
-        fclose(fp);
-        return -1;
+        lame_close(writer->lame);
+        fclose(writer->fp);
+        free(writer);
+        return NULL;
     }
-    
-    // Encode audio in chunks
-    const int chunk_size = 8192;
-    long samples_processed = 0;
-    size_t total_mp3_bytes = 0;
-    
-    while (samples_processed < sample_count) {
-        int samples_to_encode = (sample_count - samples_processed < chunk_size) 
-                               ? (sample_count - samples_processed) 
-                               : chunk_size;
-        
-        int mp3_bytes = lame_encode_buffer_ieee_float(
-            lame,
-            buffer + samples_processed,  // Left channel (mono)
-            NULL,                         // Right channel (NULL for mono)
-            samples_to_encode,
-            mp3_buffer + total_mp3_bytes,
-            mp3_buffer_size - total_mp3_bytes
-        );
-        
+
+    return writer;
+}
+
+int mp3_writer_write(Mp3Writer* writer, const float* samples, long count) {
+    long samples_encoded = 0;
+
+    // Encode in fixed chunks so the output buffer never has to grow
+    while (samples_encoded < count) {
+        int samples_to_encode = (count - samples_encoded < MP3_CHUNK_SIZE)
+                               ? (int)(count - samples_encoded)
+                               : MP3_CHUNK_SIZE;
+
+        int mp3_bytes = lame_encode_buffer_ieee_float(writer->lame,
+                                                      samples + samples_encoded,
+                                                      NULL,  // Mono
+                                                      samples_to_encode,
+                                                      writer->mp3_buffer,
+                                                      MP3_BUFFER_SIZE);
         if (mp3_bytes < 0) {
             fprintf(stderr, "Error: MP3 encoding failed\n");
-            free(mp3_buffer);
-            lame_close(lame);
-            fclose(fp);
+            writer->error = 1;
+            return -1;
+        }
+
+        if (fwrite(writer->mp3_buffer, 1, mp3_bytes, writer->fp) != (size_t)mp3_bytes) {
+            fprintf(stderr, "Error: Failed to write MP3 data\n");
+            writer->error = 1;
             return -1;
         }
-        
-        total_mp3_bytes += mp3_bytes;
-        samples_processed += samples_to_encode;
+
+        samples_encoded += samples_to_encode;
     }
-    
-    // Flush remaining data
-    int flush_bytes = lame_encode_flush(lame, mp3_buffer + total_mp3_bytes, 
-                                       mp3_buffer_size - total_mp3_bytes);
-    if (flush_bytes > 0) {
-        total_mp3_bytes += flush_bytes;
+
+    return 0;
+}
+
+int mp3_writer_close(Mp3Writer* writer) {
+    if (!writer) return 0;
+
+    int status = writer->error ? -1 : 0;
+
+    // Flush remaining data (fits in the 7200 bytes every buffer reserves)
+    if (status == 0) {
+        int flush_bytes = lame_encode_flush(writer->lame, writer->mp3_buffer, MP3_BUFFER_SIZE);
+        if (flush_bytes < 0 ||
+            fwrite(writer->mp3_buffer, 1, flush_bytes, writer->fp) != (size_t)flush_bytes) {
+            fprintf(stderr, "Error: Failed to write MP3 data\n");
+            status = -1;
+        }
     }
-    
-    // Write MP3 data to file
-    fwrite(mp3_buffer, 1, total_mp3_bytes, fp);
-    
+
     // Cleanup
-    free(mp3_buffer);
-    lame_close(lame);
-    fclose(fp);
-    
-    return 0;
-}
\ No newline at end of file
+    lame_close(writer->lame);
+    if (fclose(writer->fp) != 0) status = -1;
+    free(writer);
+
+    return status;
+}
+
+int write_mp3_file(const char* filename, float* buffer, long sample_count, int sample_rate) {
+    Mp3Writer* writer = mp3_writer_open(filename, sample_rate);
+    if (!writer) return -1;
+
+    int status = mp3_writer_write(writer, buffer, sample_count);
+    if (mp3_writer_close(writer) != 0) status = -1;
+
+    return status;
+}
+
+const char* mp3_writer_version(void) {
+    return get_lame_version();
+}
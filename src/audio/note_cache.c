@@ -0,0 +1,167 @@
+/**
+ * @file note_cache.c
+ * @brief LRU cache of rendered notes keyed by voice shape
+ * @author joaomrpimentel
+ * @version 1.1
+ */
+
+#include <stdlib.h>
+#include "note_cache.h"
+
+/** Initial number of hash buckets */
+#define NOTE_CACHE_BUCKETS 256
+
+static void lru_unlink(NoteCache* cache, NoteClip* clip) {
+    if (clip->lru_prev) clip->lru_prev->lru_next = clip->lru_next;
+    else cache->lru_head = clip->lru_next;
+    if (clip->lru_next) clip->lru_next->lru_prev = clip->lru_prev;
+    else cache->lru_tail = clip->lru_prev;
+    clip->lru_prev = NULL;
+    clip->lru_next = NULL;
+}
+
+static void lru_push_front(NoteCache* cache, NoteClip* clip) {
+    clip->lru_prev = NULL;
+    clip->lru_next = cache->lru_head;
+    if (cache->lru_head) cache->lru_head->lru_prev = clip;
+    else cache->lru_tail = clip;
+    cache->lru_head = clip;
+}
+
+/**
+ * @brief Removes a clip from the cache and frees it
+ */
+static void evict(NoteCache* cache, NoteClip* clip) {
+    NoteClip** link = &cache->buckets[clip->hash & (cache->bucket_count - 1)];
+    while (*link != clip) link = &(*link)->bucket_next;
+    *link = clip->bucket_next;
+
+    lru_unlink(cache, clip);
+    cache->bytes -= (size_t)clip->shape.length * sizeof(float);
+    cache->entries--;
+    cache->stats.evictions++;
+    free(clip->samples);
+    free(clip);
+}
+
+/**
+ * @brief Doubles the bucket array once the load factor reaches 1
+ */
+static void grow_buckets(NoteCache* cache) {
+    size_t count = cache->bucket_count * 2;
+    NoteClip** buckets = (NoteClip**)calloc(count, sizeof(NoteClip*));
+    if (!buckets) return;   // Keep the current table, chains just get longer
+
+    for (size_t b = 0; b < cache->bucket_count; b++) {
+        NoteClip* clip = cache->buckets[b];
+        while (clip) {
+            NoteClip* next = clip->bucket_next;
+            size_t index = clip->hash & (count - 1);
+            clip->bucket_next = buckets[index];
+            buckets[index] = clip;
+            clip = next;
+        }
+    }
+    free(cache->buckets);
+    cache->buckets = buckets;
+    cache->bucket_count = count;
+}
+
+NoteCache* note_cache_create(size_t max_bytes) {
+    NoteCache* cache = (NoteCache*)calloc(1, sizeof(NoteCache));
+    if (!cache) return NULL;
+
+    cache->bucket_count = NOTE_CACHE_BUCKETS;
+    cache->buckets = (NoteClip**)calloc(cache->bucket_count, sizeof(NoteClip*));
+    if (!cache->buckets) {
+        free(cache);
+        return NULL;
+    }
+    cache->max_bytes = max_bytes;
+    return cache;
+}
+
+NoteClip* note_cache_acquire(NoteCache* cache, const Voice* voice) {
+    uint64_t hash = voice_hash(voice);
+    size_t bytes = (size_t)voice->length * sizeof(float);
+
+    NoteClip* clip = cache->buckets[hash & (cache->bucket_count - 1)];
+    while (clip && !(clip->hash == hash && voice_same_shape(&clip->shape, voice))) {
+        clip = clip->bucket_next;
+    }
+
+    if (clip) {
+        cache->stats.hits++;
+        lru_unlink(cache, clip);
+        lru_push_front(cache, clip);
+        clip->pins++;
+        return clip;
+    }
+
+    if (voice->length <= 0 || bytes > cache->max_bytes) {
+        cache->stats.bypassed++;
+        return NULL;
+    }
+
+    // Make room before allocating, oldest unpinned clips first
+    NoteClip* victim = cache->lru_tail;
+    while (victim && cache->bytes + bytes > cache->max_bytes) {
+        NoteClip* prev = victim->lru_prev;
+        if (victim->pins == 0) evict(cache, victim);
+        victim = prev;
+    }
+
+    clip = (NoteClip*)malloc(sizeof(NoteClip));
+    float* samples = (float*)calloc(voice->length, sizeof(float));
+    if (!clip || !samples) {
+        free(clip);
+        free(samples);
+        cache->stats.bypassed++;
+        return NULL;
+    }
+
+    clip->shape = *voice;
+    clip->shape.start = 0;
+    clip->samples = samples;
+    clip->hash = hash;
+    clip->pins = 1;
+    voice_render(&clip->shape, clip->samples, 0, clip->shape.length);
+
+    if (cache->entries >= cache->bucket_count) grow_buckets(cache);
+    size_t index = hash & (cache->bucket_count - 1);
+    clip->bucket_next = cache->buckets[index];
+    cache->buckets[index] = clip;
+    lru_push_front(cache, clip);
+    cache->bytes += bytes;
+    cache->entries++;
+    cache->stats.misses++;
+    return clip;
+}
+
+void note_cache_release(NoteCache* cache, NoteClip* clip) {
+    (void)cache;
+    if (clip && clip->pins > 0) clip->pins--;
+}
+
+void note_clip_mix(const NoteClip* clip, long start, float* out, long from, long to) {
+    long begin = start > from ? start : from;
+    long end = start + clip->shape.length < to ? start + clip->shape.length : to;
+
+    for (long i = begin; i < end; i++) {
+        out[i - from] += clip->samples[i - start];
+    }
+}
+
+void note_cache_destroy(NoteCache* cache) {
+    if (!cache) return;
+
+    NoteClip* clip = cache->lru_head;
+    while (clip) {
+        NoteClip* next = clip->lru_next;
+        free(clip->samples);
+        free(clip);
+        clip = next;
+    }
+    free(cache->buckets);
+    free(cache);
+}
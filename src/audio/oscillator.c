@@ -0,0 +1,48 @@
+/**
+ * @file oscillator.c
+ * @brief Phase-accumulator oscillator implementation
+ * @author joaomrpimentel
+ * @version 1.1
+ */
+
+#include <math.h>
+#include "oscillator.h"
+
+double osc_phase_at(long sample, float freq, int sample_rate) {
+    double cycles = (double)sample * (double)freq / (double)sample_rate;
+    return cycles - floor(cycles);
+}
+
+void osc_fill(WaveType wave, float phase, float step, float* out, int count) {
+    // One loop per waveform keeps the switch out of the inner loop
+    switch (wave) {
+        case WAVE_SINE:
+            for (int i = 0; i < count; i++)
+                out[i] = osc_wave_value(WAVE_SINE, osc_wrap(phase + (float)i * step));
+            break;
+        case WAVE_SQUARE:
+            for (int i = 0; i < count; i++)
+                out[i] = osc_wave_value(WAVE_SQUARE, osc_wrap(phase + (float)i * step));
+            break;
+        case WAVE_SAWTOOTH:
+            for (int i = 0; i < count; i++)
+                out[i] = osc_wave_value(WAVE_SAWTOOTH, osc_wrap(phase + (float)i * step));
+            break;
+        case WAVE_TRIANGLE:
+            for (int i = 0; i < count; i++)
+                out[i] = osc_wave_value(WAVE_TRIANGLE, osc_wrap(phase + (float)i * step));
+            break;
+        default:
+            for (int i = 0; i < count; i++) out[i] = 0.0f;
+            break;
+    }
+}
+
+void osc_fill_glide(WaveType wave, float phase, float step, float step_delta,
+                    float* out, int count) {
+    for (int i = 0; i < count; i++) {
+        float fi = (float)i;
+        float p = phase + fi * step + (fi * (fi - 1.0f) * 0.5f) * step_delta;
+        out[i] = osc_wave_value(wave, osc_wrap(p));
+    }
+}
@@ -0,0 +1,253 @@
+/**
+ * @file pcm_writer.c
+ * @brief Buffered PCM sample output shared by the WAV and RAW writers
+ * @author joaomrpimentel
+ * @version 1.1
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "pcm_writer.h"
+#include "dsp.h"
+
+/** Output buffer size in bytes; one write() per full buffer */
+#define PCM_BUFFER_SIZE (1 << 20)
+
+/** Output buffer alignment (page size) */
+#define PCM_BUFFER_ALIGN 4096
+
+/** Samples converted per step */
+#define PCM_BLOCK_SIZE 4096
+
+/** Initial state of the dither noise generator (fixed: output is reproducible) */
+#define PCM_DITHER_SEED 0x9E3779B9u
+
+struct PcmWriter {
+    int fd;
+    PcmFormat format;
+    bool dither;
+    uint32_t noise;                     /**< xorshift32 state */
+    unsigned char* buffer;              /**< PCM_BUFFER_SIZE bytes, page aligned */
+    size_t used;                        /**< Bytes pending in buffer */
+    long samples;
+    int error;
+    float dithered[PCM_BLOCK_SIZE];     /**< Input plus dither noise */
+    int32_t ints[PCM_BLOCK_SIZE];       /**< 24-bit intermediates */
+    int16_t shorts[PCM_BLOCK_SIZE];     /**< 16-bit intermediates */
+};
+
+int pcm_format_bytes(PcmFormat format) {
+    switch (format) {
+        case PCM_INT16: return 2;
+        case PCM_INT24: return 3;
+        default:        return 4;
+    }
+}
+
+bool pcm_format_from_bits(int bits, PcmFormat* format) {
+    switch (bits) {
+        case 16: *format = PCM_INT16; return true;
+        case 24: *format = PCM_INT24; return true;
+        case 32: *format = PCM_FLOAT32; return true;
+        default: return false;
+    }
+}
+
+/**
+ * @brief Writes a whole byte range, retrying short writes
+ * @return 0 on success, -1 on error
+ */
+static int write_all(int fd, const unsigned char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        data += written;
+        size -= (size_t)written;
+    }
+    return 0;
+}
+
+/**
+ * @brief Writes out the pending buffer
+ * @return 0 on success, -1 on error
+ */
+static int pcm_flush(PcmWriter* writer) {
+    if (writer->used > 0 && write_all(writer->fd, writer->buffer, writer->used) != 0) {
+        writer->error = 1;
+    }
+    writer->used = 0;
+    return writer->error ? -1 : 0;
+}
+
+/**
+ * @brief Returns room for size more bytes, flushing if needed
+ * @return Destination in the buffer, or NULL on write error
+ */
+static unsigned char* pcm_reserve(PcmWriter* writer, size_t size) {
+    if (writer->used + size > PCM_BUFFER_SIZE && pcm_flush(writer) != 0) return NULL;
+    unsigned char* dest = writer->buffer + writer->used;
+    writer->used += size;
+    return dest;
+}
+
+/**
+ * @brief Adds triangular (TPDF) noise of +-1 LSB to a block
+ * @param writer Writer holding the noise state
+ * @param in Input samples
+ * @param count Number of samples (<= PCM_BLOCK_SIZE)
+ * @param scale Full-scale integer value of the target format
+ * @return writer->dithered
+ *
+ * Decorrelates the quantization error from the signal, which turns the
+ * distortion of quiet passages into a constant low noise floor.
+ */
+static const float* pcm_dither(PcmWriter* writer, const float* in, int count, float scale) {
+    const float lsb = 1.0f / scale / 16777216.0f;
+    uint32_t x = writer->noise;
+
+    for (int i = 0; i < count; i++) {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        int32_t a = (int32_t)(x >> 8);
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        int32_t b = (int32_t)(x >> 8);
+        writer->dithered[i] = in[i] + (float)(a - b) * lsb;
+    }
+
+    writer->noise = x;
+    return writer->dithered;
+}
+
+/**
+ * @brief Packs 24-bit integers as little-endian byte triplets
+ */
+static void pack_int24(unsigned char* dest, const int32_t* pcm, int count) {
+    for (int i = 0; i < count; i++) {
+        uint32_t v = (uint32_t)pcm[i];
+        dest[3 * i] = (unsigned char)v;
+        dest[3 * i + 1] = (unsigned char)(v >> 8);
+        dest[3 * i + 2] = (unsigned char)(v >> 16);
+    }
+}
+
+PcmWriter* pcm_writer_open(const char* filename, PcmFormat format, bool dither,
+                           const void* header, size_t header_size) {
+    PcmWriter* writer = (PcmWriter*)calloc(1, sizeof(PcmWriter));
+    void* buffer = NULL;
+    if (!writer || header_size > PCM_BUFFER_SIZE ||
+        posix_memalign(&buffer, PCM_BUFFER_ALIGN, PCM_BUFFER_SIZE) != 0) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        free(writer);
+        return NULL;
+    }
+
+    writer->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (writer->fd < 0) {
+        fprintf(stderr, "Error: Cannot write to file '%s'\n", filename);
+        free(buffer);
+        free(writer);
+        return NULL;
+    }
+
+    writer->buffer = (unsigned char*)buffer;
+    writer->format = format;
+    writer->dither = dither && format != PCM_FLOAT32;
+    writer->noise = PCM_DITHER_SEED;
+    if (header_size > 0) {
+        memcpy(writer->buffer, header, header_size);
+        writer->used = header_size;
+    }
+    return writer;
+}
+
+int pcm_writer_write(PcmWriter* writer, const float* samples, long count) {
+    const DspKernels* dsp = dsp_kernels();
+    int bytes = pcm_format_bytes(writer->format);
+
+    for (long done = 0; done < count; ) {
+        int block = count - done < PCM_BLOCK_SIZE ? (int)(count - done) : PCM_BLOCK_SIZE;
+        const float* in = samples + done;
+        unsigned char* dest = pcm_reserve(writer, (size_t)block * bytes);
+        if (!dest) return -1;
+
+        switch (writer->format) {
+            case PCM_INT16:
+                if (writer->dither) in = pcm_dither(writer, in, block, INT16_SCALE);
+                dsp->float_to_int16(in, writer->shorts, block);
+                memcpy(dest, writer->shorts, (size_t)block * sizeof(int16_t));
+                break;
+            case PCM_INT24:
+                // Truncation would swallow the dither noise around zero: round it
+                if (writer->dither) {
+                    in = pcm_dither(writer, in, block, INT24_SCALE);
+                    dsp->float_to_int24(in, writer->ints, block);
+                } else {
+                    dsp->float_to_int(in, writer->ints, block, INT24_SCALE);
+                }
+                pack_int24(dest, writer->ints, block);
+                break;
+            default:
+                memcpy(dest, in, (size_t)block * sizeof(float));
+                break;
+        }
+
+        writer->samples += block;
+        done += block;
+    }
+    return 0;
+}
+
+int pcm_writer_write_pcm24(PcmWriter* writer, const int32_t* pcm, long count) {
+    for (long done = 0; done < count; ) {
+        int block = count - done < PCM_BLOCK_SIZE ? (int)(count - done) : PCM_BLOCK_SIZE;
+        unsigned char* dest = pcm_reserve(writer, (size_t)block * 3);
+        if (!dest) return -1;
+
+        pack_int24(dest, pcm + done, block);
+        writer->samples += block;
+        done += block;
+    }
+    return 0;
+}
+
+int pcm_writer_append(PcmWriter* writer, const void* data, size_t size) {
+    if (size > PCM_BUFFER_SIZE) {
+        if (pcm_flush(writer) != 0) return -1;
+        if (write_all(writer->fd, (const unsigned char*)data, size) != 0) writer->error = 1;
+        return writer->error ? -1 : 0;
+    }
+    unsigned char* dest = pcm_reserve(writer, size);
+    if (!dest) return -1;
+    memcpy(dest, data, size);
+    return 0;
+}
+
+long pcm_writer_samples(const PcmWriter* writer) {
+    return writer->samples;
+}
+
+int pcm_writer_patch(PcmWriter* writer, size_t offset, const void* data, size_t size) {
+    if (pcm_flush(writer) != 0) return -1;
+    if (pwrite(writer->fd, data, size, (off_t)offset) != (ssize_t)size) {
+        writer->error = 1;
+        return -1;
+    }
+    return 0;
+}
+
+int pcm_writer_close(PcmWriter* writer) {
+    if (!writer) return 0;
+
+    int status = pcm_flush(writer);
+    if (close(writer->fd) != 0) status = -1;
+    free(writer->buffer);
+    free(writer);
+
+    return status;
+}
@@ -1,22 +1,58 @@
-
 /**
  * @file raw_writer.c
  * @brief Raw PCM file export implementation
  * @author joaomrpimentel
- * @version 1.0
+ * @version 1.2
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "raw_writer.h"
 
-void write_raw_file(const char* filename, float* buffer, long sample_count) {
-    FILE* fp = fopen(filename, "wb");
-    if (!fp) {
-        fprintf(stderr, "Error: Cannot write to file '%s'\n", filename);
-        return;
+struct RawWriter {
+    PcmWriter* pcm;
+};
+
+RawWriter* raw_writer_open_format(const char* filename, PcmFormat format, bool dither) {
+    RawWriter* writer = (RawWriter*)calloc(1, sizeof(RawWriter));
+    if (!writer) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return NULL;
     }
 
-    // Write raw float samples directly
-    fwrite(buffer, sizeof(float), sample_count, fp);
-    fclose(fp);
-}
\ No newline at end of file
+    writer->pcm = pcm_writer_open(filename, format, dither, NULL, 0);
+    if (!writer->pcm) {
+        free(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+RawWriter* raw_writer_open(const char* filename) {
+    return raw_writer_open_format(filename, PCM_FLOAT32, false);
+}
+
+int raw_writer_write(RawWriter* writer, const float* samples, long count) {
+    return pcm_writer_write(writer->pcm, samples, count);
+}
+
+int raw_writer_write_pcm24(RawWriter* writer, const int32_t* pcm, long count) {
+    return pcm_writer_write_pcm24(writer->pcm, pcm, count);
+}
+
+int raw_writer_close(RawWriter* writer) {
+    if (!writer) return 0;
+
+    int status = pcm_writer_close(writer->pcm);
+    free(writer);
+
+    return status;
+}
+
+void write_raw_file(const char* filename, float* buffer, long sample_count) {
+    RawWriter* writer = raw_writer_open(filename);
+    if (!writer) return;
+
+    raw_writer_write(writer, buffer, sample_count);
+    raw_writer_close(writer);
+}
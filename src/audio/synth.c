@@ -2,97 +2,720 @@
  * @file synth.c
  * @brief Audio synthesis engine implementation
  * @author joaomrpimentel
- * @version 1.0
+ * @version 1.8
  */
 
-#include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
+#include <stdbool.h>
 #include "synth.h"
+#include "note_list.h"
+#include "voice.h"
+#include "dsp.h"
+#include "thread_pool.h"
+#include "note_index.h"
+
+/** Samples per render tile (about 1.5 s at 44.1 kHz) */
+#define RENDER_TILE_SIZE 65536
+
+/**
+ * @brief Shared, read-only description of one render
+ */
+typedef struct {
+    const NoteList* list;
+    float* buffer;
+    long total_samples;
+    const NoteIndex* index; /**< Note ranges, or NULL to scan the list from the start */
+    bool sorted;        /**< Notes are ordered by start time */
+    VoicePhase phase;   /**< Oscillator phase at note-on */
+    int sample_rate;    /**< Output sample rate in Hz */
+    bool draft;         /**< Voices use draft oscillators */
+} RenderJob;
+
+/**
+ * @brief Time tile handed to a worker thread
+ */
+typedef struct {
+    const RenderJob* job;
+    long from;
+    long to;
+} RenderTile;
+
+static long note_start_sample(const NoteList* list, size_t index, int sample_rate) {
+    return (long)(list->start_time[index] * sample_rate);
+}
+
+/**
+ * @brief Prepares the voice of one note in the list
+ * @param voice Output voice
+ * @param list Note list
+ * @param index Note index
+ * @param phase Phase policy
+ * @param sample_rate Sample rate in Hz
+ * @param draft Use the draft oscillator
+ */
+static void prepare_voice(Voice* voice, const NoteList* list, size_t index,
+                          VoicePhase phase, int sample_rate, bool draft) {
+    NoteEvent note;
+    note_list_get(list, index, &note);
+    voice_init(voice, &note, sample_rate, phase);
+    if (draft) voice_use_draft_oscillator(voice);
+}
+
+long synth_song_length(const NoteList* list, int sample_rate) {
+    if (list->size == 0) return 0;
+
+    size_t last = list->size - 1;
+    float total_duration = list->start_time[last] + list->duration[last] +
+                          note_list_state(list, last)->envelope.release + 1.0f;
+    return (long)(sample_rate * total_duration);
+}
 
 /**
- * @brief Generates oscillator sample for given waveform type
- * @param wave Waveform type (SINE, SQUARE, SAWTOOTH, TRIANGLE)
- * @param freq Frequency in Hz
- * @param t Global time in seconds
- * @return Sample value in range [-1.0, 1.0]
- * 
- * Implementation details:
- * - SINE: Pure sinusoidal wave
- * - SQUARE: Sign of sine wave (hard transitions)
- * - SAWTOOTH: Linear ramp with period-based wrapping
- * - TRIANGLE: Arcsin of sine wave for smooth triangle shape
+ * @brief Checks that notes are ordered by start sample
+ * @param list Note list
+ * @param sample_rate Sample rate in Hz
+ * @return true if start samples never decrease (always the case for parse_jshl_source output)
  */
-static float get_osc_value(WaveType wave, float freq, float t) {
-    float phase = t * freq * 2.0f * PI;
-    switch (wave) {
-        case WAVE_SINE:     return sinf(phase);
-        case WAVE_SQUARE:   return sinf(phase) >= 0.0f ? 1.0f : -1.0f;
-        case WAVE_SAWTOOTH: return 2.0f * ( (t * freq) - floorf(0.5f + (t * freq)) );
-        case WAVE_TRIANGLE: return asinf(sinf(phase)) * (2.0f / PI);
-        default:            return 0.0f;
+static bool notes_sorted(const NoteList* list, int sample_rate) {
+    for (size_t i = 1; i < list->size; i++) {
+        if (note_start_sample(list, i, sample_rate) < note_start_sample(list, i - 1, sample_rate)) {
+            return false;
+        }
     }
+    return true;
 }
 
-float* render_audio(NoteList* list, long* total_samples) {
+/**
+ * @brief Indexes the sample range of every note
+ * @param index Index to build
+ * @param list Note list
+ * @param sample_rate Sample rate in Hz
+ * @return 0 on success, -1 on allocation failure
+ *
+ * Ranges span note-on to the end of the release, plus one sample of
+ * slack for rounding, so they cover every sample the voice produces.
+ */
+static int build_note_index(NoteIndex* index, const NoteList* list, int sample_rate) {
+    long* starts = (long*)malloc((list->size ? list->size : 1) * sizeof(long));
+    long* ends = (long*)malloc((list->size ? list->size : 1) * sizeof(long));
+    int status = -1;
+
+    if (starts && ends) {
+        for (size_t i = 0; i < list->size; i++) {
+            float release = note_list_state(list, i)->envelope.release;
+            starts[i] = note_start_sample(list, i, sample_rate);
+            ends[i] = starts[i] + (long)((list->duration[i] + release) * sample_rate) + 1;
+        }
+        status = note_index_build(index, starts, ends, list->size);
+    }
+
+    free(starts);
+    free(ends);
+    return status;
+}
+
+/**
+ * @brief Window of a tile being mixed, handed to the index visitor
+ */
+typedef struct {
+    const RenderJob* job;
+    float* out;
+    long from;
+    long to;
+} TileMix;
+
+/**
+ * @brief Mixes one note into a tile
+ * @param note Note index
+ * @param context TileMix
+ */
+static void mix_note(size_t note, void* context) {
+    const TileMix* mix = (const TileMix*)context;
+    Voice voice;
+    prepare_voice(&voice, mix->job->list, note, mix->job->phase,
+                  mix->job->sample_rate, mix->job->draft);
+    voice_render(&voice, mix->out, mix->from, mix->to);
+}
+
+/**
+ * @brief Renders and clips the absolute sample range [from, to)
+ * @param job Render description
+ * @param from First sample of the tile
+ * @param to One past the last sample of the tile
+ *
+ * Notes are mixed in list order, which makes every sample identical no
+ * matter how the timeline is split into tiles. With an index (only built
+ * for lists ordered by start time, where its order is list order) just
+ * the notes overlapping the tile are visited.
+ */
+static void render_tile(const RenderJob* job, long from, long to) {
+    TileMix mix = { job, job->buffer + from, from, to };
+
+    if (job->index) {
+        note_index_query(job->index, from, to, mix_note, &mix);
+    } else {
+        for (size_t i = 0; i < job->list->size; i++) {
+            if (job->sorted && note_start_sample(job->list, i, job->sample_rate) >= to) break;
+            mix_note(i, &mix);
+        }
+    }
+
+    dsp_kernels()->clip(mix.out, to - from);
+}
+
+/**
+ * @brief Thread pool entry point for one tile
+ * @param arg RenderTile to process
+ */
+static void render_tile_task(void* arg) {
+    RenderTile* tile = (RenderTile*)arg;
+    render_tile(tile->job, tile->from, tile->to);
+}
+
+/**
+ * @brief Renders all tiles on a thread pool
+ * @param job Render description
+ * @param threads Worker thread count
+ * @return 0 on success, -1 if the pool could not be used
+ */
+static int render_parallel(const RenderJob* job, int threads) {
+    long tile_count = (job->total_samples + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+    RenderTile* tiles = (RenderTile*)malloc(tile_count * sizeof(RenderTile));
+    if (!tiles) return -1;
+
+    ThreadPool* pool = thread_pool_create(threads);
+    if (!pool) {
+        free(tiles);
+        return -1;
+    }
+
+    long submitted = 0;
+    for (long t = 0; t < tile_count; t++) {
+        tiles[t].job = job;
+        tiles[t].from = t * RENDER_TILE_SIZE;
+        tiles[t].to = tiles[t].from + RENDER_TILE_SIZE;
+        if (tiles[t].to > job->total_samples) tiles[t].to = job->total_samples;
+
+        if (thread_pool_submit(pool, render_tile_task, &tiles[t]) != 0) break;
+        submitted++;
+    }
+
+    // Tiles the pool could not take are rendered here
+    for (long t = submitted; t < tile_count; t++) {
+        render_tile(job, tiles[t].from, tiles[t].to);
+    }
+
+    thread_pool_destroy(pool);
+    free(tiles);
+    return 0;
+}
+
+void synth_options_init(SynthOptions* options) {
+    options->threads = 1;
+    options->phase = VOICE_PHASE_GLOBAL;
+    options->loops = NULL;
+    options->note_cache = NULL;
+    options->sample_rate = SAMPLE_RATE;
+    options->draft = false;
+}
+
+float* render_audio_with_options(NoteList* list, long* total_samples,
+                                 const SynthOptions* options) {
     if (list->size == 0) {
         *total_samples = 0;
         return NULL;
     }
 
-    NoteEvent last_note = list->notes[list->size - 1];
-    float total_duration = last_note.start_time + last_note.duration + 
-                          last_note.state.envelope.release + 1.0f;
-    *total_samples = (long)(SAMPLE_RATE * total_duration);
+    int sample_rate = options ? options->sample_rate : SAMPLE_RATE;
+    *total_samples = synth_song_length(list, sample_rate);
+
+    // Loop clips and cached notes are tracked by the streaming renderer
+    if (options && (options->loops || options->note_cache)) {
+        float* streamed = (float*)malloc(*total_samples * sizeof(float));
+        SynthStream stream;
+        if (!streamed || synth_stream_init(&stream, list, options) != 0) {
+            free(streamed);
+            *total_samples = 0;
+            return NULL;
+        }
+        long rendered = synth_stream_read(&stream, streamed, *total_samples);
+        synth_stream_free(&stream);
+        if (rendered < 0) {
+            free(streamed);
+            *total_samples = 0;
+            return NULL;
+        }
+        return streamed;
+    }
 
     float* buffer = (float*)calloc(*total_samples, sizeof(float));
     if (!buffer) {
-        fprintf(stderr, "Error: Audio buffer allocation failed\n");
-        exit(1);
-    }
-
-    for (size_t i = 0; i < list->size; i++) {
-        NoteEvent note = list->notes[i];
-        SynthState s = note.state;
-        Envelope e = s.envelope;
-        
-        float gain = (s.wave == WAVE_SINE) ? 1.0f : 
-                    (s.wave == WAVE_TRIANGLE ? 0.8f : 0.25f);
-        
-        long start_sample = (long)(note.start_time * SAMPLE_RATE);
-        long end_sample = (long)((note.start_time + note.duration + e.release) * SAMPLE_RATE);
-
-        for (long j = start_sample; j < end_sample && j < *total_samples; j++) {
-            float t = (float)j / SAMPLE_RATE;
-            float note_t = t - note.start_time;
-
-            float env_gain = 0.0f;
-            if (note_t < 0.0f) continue;
-            if (note_t < e.attack) {
-                env_gain = note_t / e.attack;
-            } else if (note_t < e.attack + e.decay) {
-                env_gain = 1.0f - (1.0f - e.sustain) * ((note_t - e.attack) / e.decay);
-            } else if (note_t < note.duration) {
-                env_gain = e.sustain;
-            } else if (note_t < note.duration + e.release) {
-                env_gain = e.sustain * (1.0f - ((note_t - note.duration) / e.release));
-            }
-            env_gain = fmaxf(0.0f, fminf(1.0f, env_gain));
+        *total_samples = 0;
+        return NULL;
+    }
 
-            float current_freq = note.freq;
-            if (s.slide > 0.0f && s.last_freq > 0.0f && note_t < s.slide) {
-                current_freq = s.last_freq + (note.freq - s.last_freq) * (note_t / s.slide);
-            }
+    RenderJob job;
+    job.list = list;
+    job.buffer = buffer;
+    job.total_samples = *total_samples;
+    job.index = NULL;
+    job.sorted = notes_sorted(list, sample_rate);
+    job.phase = options ? options->phase : VOICE_PHASE_GLOBAL;
+    job.sample_rate = sample_rate;
+    job.draft = options ? options->draft : false;
+
+    int threads = options ? options->threads : 1;
+    if (threads < 1) threads = thread_pool_cpu_count();
+
+    // A single pass over the whole song needs no index
+    NoteIndex index;
+    bool tiled = threads > 1 && *total_samples > RENDER_TILE_SIZE;
+    if (tiled && job.sorted && build_note_index(&index, list, sample_rate) == 0) {
+        job.index = &index;
+    }
+    if (!tiled || render_parallel(&job, threads) != 0) {
+        render_tile(&job, 0, *total_samples);
+    }
+    if (job.index) note_index_free(&index);
+
+    return buffer;
+}
+
+float* render_audio(NoteList* list, long* total_samples) {
+    return render_audio_with_options(list, total_samples, NULL);
+}
+
+/**
+ * @brief Sub-window of a stream chunk handed to a worker thread
+ */
+typedef struct {
+    const SynthStream* stream;
+    float* out;
+    long from;
+    long to;
+} StreamTile;
 
-            float osc_value = get_osc_value(s.wave, current_freq, t);
-            buffer[j] += osc_value * env_gain * gain * MASTER_GAIN;
+/**
+ * @brief Mixes the active voices and clips into [from, to) and clips the result
+ * @param stream Stream whose active set covers the window
+ * @param out Output buffer for the window
+ * @param from First absolute sample
+ * @param to One past the last absolute sample
+ */
+static void stream_render_window(const SynthStream* stream, float* out, long from, long to) {
+    for (long i = 0; i < to - from; i++) out[i] = 0.0f;
+
+    for (size_t v = 0; v < stream->active_count; v++) {
+        const ActiveVoice* active = &stream->active[v];
+        if (active->clip) note_clip_mix(active->clip, active->voice.start, out, from, to);
+        else voice_render(&active->voice, out, from, to);
+    }
+
+    for (size_t c = 0; c < stream->active_clip_count; c++) {
+        loop_clip_mix(stream->active_clips[c].clip, stream->active_clips[c].anchor,
+                      out, from, to);
+    }
+
+    dsp_kernels()->clip(out, to - from);
+}
+
+/**
+ * @brief Thread pool entry point for one stream sub-window
+ * @param arg StreamTile to process
+ */
+static void stream_tile_task(void* arg) {
+    StreamTile* tile = (StreamTile*)arg;
+    stream_render_window(tile->stream, tile->out, tile->from, tile->to);
+}
+
+/**
+ * @brief Appends a clip instance to the active set
+ * @param stream Stream to update
+ * @param instance Instance starting to sound
+ * @return 0 on success, -1 on allocation failure
+ */
+static int stream_activate_clip(SynthStream* stream, const ClipInstance* instance) {
+    if (stream->active_clip_count == stream->active_clip_capacity) {
+        size_t capacity = stream->active_clip_capacity ? stream->active_clip_capacity * 2 : 4;
+        ActiveClip* grown = (ActiveClip*)realloc(stream->active_clips,
+                                                 capacity * sizeof(ActiveClip));
+        if (!grown) return -1;
+        stream->active_clips = grown;
+        stream->active_clip_capacity = capacity;
+    }
+    stream->active_clips[stream->active_clip_count].clip = &stream->clips.clips[instance->clip];
+    stream->active_clips[stream->active_clip_count].anchor = instance->anchor;
+    stream->active_clip_count++;
+    return 0;
+}
+
+/**
+ * @brief Appends a voice to the active set
+ * @param stream Stream to update
+ * @param voice Voice starting to sound
+ * @return 0 on success, -1 on allocation failure
+ */
+static int stream_activate_voice(SynthStream* stream, const Voice* voice) {
+    if (stream->active_count == stream->active_capacity) {
+        size_t capacity = stream->active_capacity ? stream->active_capacity * 2 : 16;
+        ActiveVoice* grown = (ActiveVoice*)realloc(stream->active,
+                                                   capacity * sizeof(ActiveVoice));
+        if (!grown) return -1;
+        stream->active = grown;
+        stream->active_capacity = capacity;
+    }
+    ActiveVoice* active = &stream->active[stream->active_count++];
+    active->voice = *voice;
+    active->clip = stream->note_cache ? note_cache_acquire(stream->note_cache, voice) : NULL;
+    return 0;
+}
+
+/**
+ * @brief Updates the active set for the window [from, to)
+ * @param stream Stream to update
+ * @param from First absolute sample of the window
+ * @param to One past the last absolute sample
+ * @return 0 on success, -1 on allocation failure
+ *
+ * Finished voices are dropped and newly started notes appended, which
+ * keeps the active set in list order. Notes covered by a clip instance
+ * are skipped and the clip is activated instead.
+ */
+static int stream_update_active(SynthStream* stream, long from, long to) {
+    size_t kept = 0;
+    for (size_t v = 0; v < stream->active_count; v++) {
+        const Voice* voice = &stream->active[v].voice;
+        if (voice->start + voice->length > from) {
+            stream->active[kept++] = stream->active[v];
+        } else if (stream->active[v].clip) {
+            note_cache_release(stream->note_cache, stream->active[v].clip);
         }
     }
+    stream->active_count = kept;
 
-    for (long i = 0; i < *total_samples; i++) {
-        if (buffer[i] > 1.0f) buffer[i] = 1.0f;
-        if (buffer[i] < -1.0f) buffer[i] = -1.0f;
+    kept = 0;
+    for (size_t c = 0; c < stream->active_clip_count; c++) {
+        const ActiveClip* active = &stream->active_clips[c];
+        if (active->anchor + active->clip->length > from) {
+            stream->active_clips[kept++] = *active;
+        }
     }
+    stream->active_clip_count = kept;
 
-    return buffer;
-}
\ No newline at end of file
+    while (stream->next_note < stream->list->size) {
+        if (stream->next_instance < stream->clips.instance_count &&
+            stream->clips.instances[stream->next_instance].first_note == stream->next_note) {
+            const ClipInstance* instance = &stream->clips.instances[stream->next_instance];
+            if (instance->anchor >= to) break;
+            if (stream_activate_clip(stream, instance) != 0) return -1;
+            stream->next_note += instance->note_count;
+            stream->next_instance++;
+            continue;
+        }
+
+        Voice voice;
+        prepare_voice(&voice, stream->list, stream->next_note, stream->phase,
+                      stream->sample_rate, stream->draft);
+        if (stream->sorted && voice.start >= to) break;
+        if (stream_activate_voice(stream, &voice) != 0) return -1;
+        stream->next_note++;
+    }
+    return 0;
+}
+
+int synth_stream_init(SynthStream* stream, const NoteList* list, const SynthOptions* options) {
+    stream->list = list;
+    stream->sample_rate = options ? options->sample_rate : SAMPLE_RATE;
+    stream->draft = options ? options->draft : false;
+    stream->total_samples = synth_song_length(list, stream->sample_rate);
+    stream->position = 0;
+    stream->next_note = 0;
+    stream->sorted = notes_sorted(list, stream->sample_rate);
+    stream->indexed = false;
+    stream->phase = options ? options->phase : VOICE_PHASE_GLOBAL;
+    stream->note_cache = options ? options->note_cache : NULL;
+    stream->active = NULL;
+    stream->active_count = 0;
+    stream->active_capacity = 0;
+    stream->next_instance = 0;
+    stream->active_clips = NULL;
+    stream->active_clip_count = 0;
+    stream->active_clip_capacity = 0;
+    stream->pool = NULL;
+    stream->threads = options ? options->threads : 1;
+    if (stream->threads < 1) stream->threads = thread_pool_cpu_count();
+
+    if (stream->threads > 1) {
+        stream->pool = thread_pool_create(stream->threads);
+        if (!stream->pool) stream->threads = 1;
+    }
+
+    // Clips rely on time order to be activated at the right note
+    const LoopList* loops = options && stream->sorted ? options->loops : NULL;
+    if (loop_clips_build(&stream->clips, list, loops, stream->phase,
+                         stream->sample_rate, stream->draft) != 0) {
+        thread_pool_destroy(stream->pool);
+        stream->pool = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static int compare_longs(const void* a, const void* b) {
+    long x = *(const long*)a;
+    long y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Finds the largest number of intervals [begin, end) sharing a point
+ * @param begins Interval starts (sorted in place)
+ * @param ends Interval ends (sorted in place)
+ * @param count Number of intervals
+ * @return Maximum overlap
+ */
+static size_t max_overlap(long* begins, long* ends, size_t count) {
+    qsort(begins, count, sizeof(long), compare_longs);
+    qsort(ends, count, sizeof(long), compare_longs);
+
+    size_t open = 0;
+    size_t best = 0;
+    size_t e = 0;
+    for (size_t b = 0; b < count; b++) {
+        while (e < count && ends[e] <= begins[b]) {
+            e++;
+            open--;
+        }
+        if (++open > best) best = open;
+    }
+    return best;
+}
+
+/**
+ * @brief Grows an array to hold at least 'needed' elements
+ * @return 0 on success, -1 on allocation failure
+ */
+static int reserve_array(void** items, size_t* capacity, size_t needed, size_t size) {
+    if (needed <= *capacity) return 0;
+    void* grown = realloc(*items, needed * size);
+    if (!grown) return -1;
+    *items = grown;
+    *capacity = needed;
+    return 0;
+}
+
+int synth_stream_reserve(SynthStream* stream, long max_frames) {
+    const NoteList* list = stream->list;
+    size_t count = list->size > stream->clips.instance_count
+                 ? list->size : stream->clips.instance_count;
+    if (count == 0) return 0;
+    if (max_frames < 1) max_frames = 1;
+    if (stream->sorted && synth_stream_index(stream) != 0) return -1;
+
+    long* begins = (long*)malloc(count * sizeof(long));
+    long* ends = (long*)malloc(count * sizeof(long));
+    if (!begins || !ends) {
+        free(begins);
+        free(ends);
+        return -1;
+    }
+
+    // A read of [from, from + max_frames) holds every voice that starts
+    // before its end and ends after its start (empty voices still take a
+    // slot until the next read)
+    size_t voices = list->size;
+    if (stream->sorted) {
+        for (size_t i = 0; i < list->size; i++) {
+            Voice voice;
+            prepare_voice(&voice, list, i, stream->phase, stream->sample_rate, stream->draft);
+            begins[i] = voice.start - max_frames + 1;
+            ends[i] = voice.start + (voice.length > 0 ? voice.length : 1);
+        }
+        voices = max_overlap(begins, ends, list->size);
+    }
+
+    for (size_t c = 0; c < stream->clips.instance_count; c++) {
+        const ClipInstance* instance = &stream->clips.instances[c];
+        begins[c] = instance->anchor - max_frames + 1;
+        long length = stream->clips.clips[instance->clip].length;
+        ends[c] = instance->anchor + (length > 0 ? length : 1);
+    }
+    size_t clips = max_overlap(begins, ends, stream->clips.instance_count);
+
+    free(begins);
+    free(ends);
+    if (reserve_array((void**)&stream->active, &stream->active_capacity,
+                      voices, sizeof(ActiveVoice)) != 0 ||
+        reserve_array((void**)&stream->active_clips, &stream->active_clip_capacity,
+                      clips, sizeof(ActiveClip)) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+long synth_stream_read(SynthStream* stream, float* out, long frames) {
+    long from = stream->position;
+    long to = from + frames;
+    if (to > stream->total_samples) to = stream->total_samples;
+    if (to <= from) return 0;
+
+    if (stream_update_active(stream, from, to) != 0) return -1;
+
+    long count = to - from;
+    int parts = stream->threads;
+    if (parts > 1 && count / parts < VOICE_BLOCK_SIZE) parts = (int)(count / VOICE_BLOCK_SIZE);
+
+    if (parts <= 1) {
+        stream_render_window(stream, out, from, to);
+    } else {
+        StreamTile tiles[parts];
+        long part = (count + parts - 1) / parts;
+        for (int p = 0; p < parts; p++) {
+            tiles[p].stream = stream;
+            tiles[p].from = from + p * part;
+            tiles[p].to = tiles[p].from + part < to ? tiles[p].from + part : to;
+            tiles[p].out = out + (tiles[p].from - from);
+            if (thread_pool_submit(stream->pool, stream_tile_task, &tiles[p]) != 0) {
+                stream_tile_task(&tiles[p]);
+            }
+        }
+        thread_pool_wait(stream->pool);
+    }
+
+    stream->position = to;
+    return count;
+}
+
+void synth_stream_rewind(SynthStream* stream) {
+    for (size_t v = 0; v < stream->active_count; v++) {
+        if (stream->active[v].clip) note_cache_release(stream->note_cache, stream->active[v].clip);
+    }
+    stream->active_count = 0;
+    stream->active_clip_count = 0;
+    stream->position = 0;
+    stream->next_note = 0;
+    stream->next_instance = 0;
+}
+
+/**
+ * @brief Finds the first clip instance that ends after a note index
+ * @param set Clip instances
+ * @param note Note index
+ * @return Index of the instance containing 'note' or the next one after it
+ */
+static size_t instance_from_note(const LoopClipSet* set, size_t note) {
+    size_t lo = 0;
+    size_t hi = set->instance_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (set->instances[mid].first_note + set->instances[mid].note_count <= note) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * @brief Seek in progress, handed to the index visitor
+ */
+typedef struct {
+    SynthStream* stream;
+    long sample;        /**< Seek target */
+    int status;         /**< 0, or -1 after an allocation failure */
+} SeekState;
+
+/**
+ * @brief Activates a note sounding across the seek target
+ * @param note Note index
+ * @param context SeekState
+ *
+ * Notes covered by a clip instance are left to the clip.
+ */
+static void seek_note(size_t note, void* context) {
+    SeekState* seek = (SeekState*)context;
+    SynthStream* stream = seek->stream;
+    size_t instance = instance_from_note(&stream->clips, note);
+    if (instance < stream->clips.instance_count &&
+        stream->clips.instances[instance].first_note <= note) {
+        return;
+    }
+
+    Voice voice;
+    prepare_voice(&voice, stream->list, note, stream->phase, stream->sample_rate, stream->draft);
+    if (voice.start + voice.length > seek->sample && stream_activate_voice(stream, &voice) != 0) {
+        seek->status = -1;
+    }
+}
+
+int synth_stream_index(SynthStream* stream) {
+    if (stream->indexed) return 0;
+    if (build_note_index(&stream->index, stream->list, stream->sample_rate) != 0) return -1;
+    stream->indexed = true;
+    return 0;
+}
+
+int synth_stream_seek(SynthStream* stream, long sample) {
+    synth_stream_rewind(stream);
+    if (sample <= 0) return 0;
+    if (sample > stream->total_samples) sample = stream->total_samples;
+    stream->position = sample;
+
+    // Without time order the first read activates every note anyway
+    if (!stream->sorted) return 0;
+
+    // Clip instances whose samples reach past 'sample'
+    const LoopClipSet* clips = &stream->clips;
+    long longest_clip = 0;
+    for (size_t c = 0; c < clips->clip_count; c++) {
+        if (clips->clips[c].length > longest_clip) longest_clip = clips->clips[c].length;
+    }
+    size_t lo = 0;
+    size_t hi = clips->instance_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (clips->instances[mid].anchor < sample - longest_clip) lo = mid + 1;
+        else hi = mid;
+    }
+    for (size_t c = lo; c < clips->instance_count && clips->instances[c].anchor < sample; c++) {
+        const ClipInstance* instance = &clips->instances[c];
+        if (instance->anchor + clips->clips[instance->clip].length <= sample) continue;
+        if (stream_activate_clip(stream, instance) != 0) return -1;
+    }
+
+    // Voices started before 'sample' whose release has not ended
+    if (synth_stream_index(stream) != 0) return -1;
+    SeekState seek = { stream, sample, 0 };
+    note_index_query(&stream->index, sample, sample, seek_note, &seek);
+    if (seek.status != 0) return -1;
+
+    // Later notes are activated by the reads; a clip instance already
+    // sounding owns the rest of its notes
+    size_t note = note_index_starts_before(&stream->index, sample);
+    size_t instance = instance_from_note(clips, note);
+    if (instance < clips->instance_count && clips->instances[instance].first_note < note) {
+        note = clips->instances[instance].first_note + clips->instances[instance].note_count;
+        instance++;
+    }
+
+    stream->next_note = note;
+    stream->next_instance = instance;
+    return 0;
+}
+
+void synth_stream_free(SynthStream* stream) {
+    thread_pool_destroy(stream->pool);
+    for (size_t v = 0; v < stream->active_count; v++) {
+        if (stream->active[v].clip) note_cache_release(stream->note_cache, stream->active[v].clip);
+    }
+    free(stream->active);
+    free(stream->active_clips);
+    loop_clips_free(&stream->clips);
+    if (stream->indexed) note_index_free(&stream->index);
+    stream->indexed = false;
+    stream->pool = NULL;
+    stream->active_clips = NULL;
+    stream->active_clip_count = 0;
+    stream->active_clip_capacity = 0;
+    stream->active = NULL;
+    stream->active_count = 0;
+    stream->active_capacity = 0;
+}
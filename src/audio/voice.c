@@ -0,0 +1,216 @@
+/**
+ * @file voice.c
+ * @brief Per-note voice preparation and block rendering
+ * @author joaomrpimentel
+ * @version 1.2
+ */
+
+#include <math.h>
+#include "voice.h"
+#include "oscillator.h"
+#include "dsp.h"
+#include "hash.h"
+
+/**
+ * @brief Converts a note-relative time to the first sample at or after it
+ * @param seconds Time since note-on in seconds
+ * @param sample_rate Sample rate in Hz
+ * @return Note-relative sample index (never negative)
+ */
+static long seconds_to_sample(double seconds, int sample_rate) {
+    double samples = ceil(seconds * sample_rate);
+    return samples > 0.0 ? (long)samples : 0;
+}
+
+/**
+ * @brief Appends an envelope segment, clipped to the voice length
+ * @param voice Voice being prepared
+ * @param begin First note-relative sample of the segment
+ * @param end One past the last note-relative sample
+ * @param level Level at sample 'begin'
+ * @param delta Level change per sample
+ */
+static void add_segment(Voice* voice, long begin, long end, float level, float delta) {
+    if (end > voice->length) end = voice->length;
+    if (end <= begin) return;
+
+    EnvSegment* seg = &voice->segments[voice->segment_count++];
+    seg->offset = begin;
+    seg->length = end - begin;
+    seg->level = level;
+    seg->delta = delta;
+}
+
+/**
+ * @brief Computes the oscillator phase at a note-relative sample
+ * @param voice Prepared voice
+ * @param k Note-relative sample index
+ * @return Phase in cycles, wrapped to [0, 1)
+ *
+ * Closed form of the accumulated phase: quadratic while gliding
+ * (linearly changing increment), linear afterwards.
+ */
+static double phase_at(const Voice* voice, long k) {
+    double glide = (double)(k < voice->glide_length ? k : voice->glide_length);
+    double p = voice->phase + glide * voice->glide_step;
+
+    if (voice->glide_length > 0) {
+        double delta = (voice->step - voice->glide_step) / voice->glide_length;
+        p += delta * glide * (glide - 1.0) * 0.5;
+    }
+    if (k > voice->glide_length) {
+        p += (double)(k - voice->glide_length) * voice->step;
+    }
+    return p - floor(p);
+}
+
+float voice_wave_gain(WaveType wave) {
+    switch (wave) {
+        case WAVE_SINE:     return 1.0f;
+        case WAVE_TRIANGLE: return 0.8f;
+        default:            return 0.25f;
+    }
+}
+
+void voice_init(Voice* voice, const NoteEvent* note, int sample_rate, VoicePhase phase) {
+    const SynthState* s = &note->state;
+    const Envelope* e = &s->envelope;
+    double sr = (double)sample_rate;
+    float sustain = fmaxf(0.0f, fminf(1.0f, e->sustain));
+    float start_freq = note->freq;
+
+    voice->start = (long)(note->start_time * sample_rate);
+    voice->length = (long)((note->duration + e->release) * sample_rate);
+    voice->wave = s->wave;
+    voice->gain = voice_wave_gain(s->wave) * MASTER_GAIN;
+    voice->step = note->freq / sr;
+    voice->glide_step = voice->step;
+    voice->glide_length = 0;
+
+    if (s->slide > 0.0f && s->last_freq > 0.0f) {
+        start_freq = s->last_freq;
+        voice->glide_step = s->last_freq / sr;
+        voice->glide_length = (long)(s->slide * sample_rate);
+    }
+
+    // Phase aligned to the song clock at note-on, or restarted
+    voice->phase = phase == VOICE_PHASE_GLOBAL
+                 ? osc_phase_at(voice->start, start_freq, sample_rate) : 0.0;
+
+    long attack_end = seconds_to_sample(e->attack, sample_rate);
+    long decay_end = seconds_to_sample((double)e->attack + e->decay, sample_rate);
+    long note_off = seconds_to_sample(note->duration, sample_rate);
+    long release_begin = note_off > decay_end ? note_off : decay_end;
+
+    voice->segment_count = 0;
+
+    if (attack_end > 0) {
+        add_segment(voice, 0, attack_end, 0.0f, (float)(1.0 / (e->attack * sr)));
+    }
+    if (decay_end > attack_end) {
+        double t = attack_end / sr - e->attack;
+        add_segment(voice, attack_end, decay_end,
+                    (float)(1.0 - (1.0 - sustain) * (t / e->decay)),
+                    (float)(-(1.0 - sustain) / (e->decay * sr)));
+    }
+    if (note_off > decay_end) {
+        add_segment(voice, decay_end, note_off, sustain, 0.0f);
+    }
+    if (e->release > 0.0f) {
+        double t = release_begin / sr - note->duration;
+        add_segment(voice, release_begin, voice->length,
+                    (float)(sustain * (1.0 - t / e->release)),
+                    (float)(-sustain / (e->release * sr)));
+    }
+}
+
+bool voice_same_shape(const Voice* a, const Voice* b) {
+    if (a->length != b->length || a->wave != b->wave || a->gain != b->gain ||
+        a->phase != b->phase || a->step != b->step || a->glide_step != b->glide_step ||
+        a->glide_length != b->glide_length || a->segment_count != b->segment_count) {
+        return false;
+    }
+
+    for (int s = 0; s < a->segment_count; s++) {
+        const EnvSegment* sa = &a->segments[s];
+        const EnvSegment* sb = &b->segments[s];
+        if (sa->offset != sb->offset || sa->length != sb->length ||
+            sa->level != sb->level || sa->delta != sb->delta) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t voice_hash(const Voice* voice) {
+    uint64_t h = HASH_SEED;
+    h = hash_bytes(h, &voice->length, sizeof(voice->length));
+    h = hash_bytes(h, &voice->wave, sizeof(voice->wave));
+    h = hash_bytes(h, &voice->gain, sizeof(voice->gain));
+    h = hash_bytes(h, &voice->phase, sizeof(voice->phase));
+    h = hash_bytes(h, &voice->step, sizeof(voice->step));
+    h = hash_bytes(h, &voice->glide_step, sizeof(voice->glide_step));
+    h = hash_bytes(h, &voice->glide_length, sizeof(voice->glide_length));
+    for (int s = 0; s < voice->segment_count; s++) {
+        const EnvSegment* seg = &voice->segments[s];
+        h = hash_bytes(h, &seg->offset, sizeof(seg->offset));
+        h = hash_bytes(h, &seg->length, sizeof(seg->length));
+        h = hash_bytes(h, &seg->level, sizeof(seg->level));
+        h = hash_bytes(h, &seg->delta, sizeof(seg->delta));
+    }
+    return h;
+}
+
+void voice_use_draft_oscillator(Voice* voice) {
+    if (voice->wave == WAVE_SINE) voice->wave = WAVE_TRIANGLE;
+}
+
+void voice_render(const Voice* voice, float* out, long from, long to) {
+    long first = (from > voice->start ? from : voice->start) - voice->start;
+    long last = (to < voice->start + voice->length ? to : voice->start + voice->length)
+                - voice->start;
+    if (first >= last) return;
+
+    const DspKernels* dsp = dsp_kernels();
+    float osc[VOICE_BLOCK_SIZE];
+    long glide_end = voice->glide_length;
+    double glide_delta = glide_end > 0
+                       ? (voice->step - voice->glide_step) / glide_end : 0.0;
+
+    for (int s = 0; s < voice->segment_count; s++) {
+        const EnvSegment* seg = &voice->segments[s];
+        long seg_end = seg->offset + seg->length;
+        long k = first > seg->offset ? first : seg->offset;
+        long end = last < seg_end ? last : seg_end;
+
+        while (k < end) {
+            // Block grid is anchored to note-on, so values never depend on the window
+            long block = k - (k % VOICE_BLOCK_SIZE);
+            long chunk = block > seg->offset ? block : seg->offset;
+            if (glide_end > chunk && glide_end <= k) chunk = glide_end;
+
+            long chunk_end = block + VOICE_BLOCK_SIZE;
+            if (chunk_end > seg_end) chunk_end = seg_end;
+            if (chunk < glide_end && glide_end < chunk_end) chunk_end = glide_end;
+
+            int i_begin = (int)(k - chunk);
+            int i_end = (int)((end < chunk_end ? end : chunk_end) - chunk);
+            float phase = (float)phase_at(voice, chunk);
+
+            if (chunk < glide_end) {
+                float step = (float)(voice->glide_step + chunk * glide_delta);
+                osc_fill_glide(voice->wave, phase, step, (float)glide_delta, osc, i_end);
+            } else {
+                dsp->osc_fill(voice->wave, phase, (float)voice->step, osc, i_end);
+            }
+
+            // Envelope ramp times gain, mixed into the window
+            float level = seg->level + (float)(chunk - seg->offset) * seg->delta;
+            long base = voice->start + chunk - from;
+            dsp->mix_ramp(out + base + i_begin, osc + i_begin, i_end - i_begin,
+                          level, seg->delta, i_begin, voice->gain);
+
+            k = chunk + i_end;
+        }
+    }
+}
@@ -2,47 +2,155 @@
  * @file wav_writer.c
  * @brief WAV file export implementation
  * @author joaomrpimentel
- * @version 1.0
+ * @version 1.3
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include "wav_writer.h"
 #include "jshl_compiler.h"
 
-void write_wav_file(const char* filename, float* buffer, long sample_count) {
-    FILE* fp = fopen(filename, "wb");
-    if (!fp) {
-        fprintf(stderr, "Error: Cannot write to file '%s'\n", filename);
-        return;
+/** Size of the RIFF/fmt/data header */
+#define WAV_HEADER_SIZE 44
+
+/** Byte offset of the RIFF chunk size field */
+#define WAV_RIFF_SIZE_OFFSET 4
+
+/** Byte offset of the data chunk size field */
+#define WAV_DATA_SIZE_OFFSET 40
+
+/** Largest data chunk whose RIFF size (header, data, pad byte) fits in 32 bits */
+#define WAV_MAX_DATA_SIZE (UINT32_MAX - (WAV_HEADER_SIZE - 8) - 1)
+
+/** fmt chunk format codes */
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_IEEE_FLOAT 3
+
+struct WavWriter {
+    PcmWriter* pcm;
+    int sample_bytes;
+};
+
+/**
+ * @brief Stores little-endian integers into a header
+ */
+static void put_u16(unsigned char* dest, uint16_t value) {
+    dest[0] = (unsigned char)value;
+    dest[1] = (unsigned char)(value >> 8);
+}
+
+static void put_u32(unsigned char* dest, uint32_t value) {
+    put_u16(dest, (uint16_t)value);
+    put_u16(dest + 2, (uint16_t)(value >> 16));
+}
+
+WavWriter* wav_writer_open_format(const char* filename, int sample_rate,
+                                  PcmFormat format, bool dither) {
+    WavWriter* writer = (WavWriter*)calloc(1, sizeof(WavWriter));
+    if (!writer) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return NULL;
+    }
+
+    uint16_t num_channels = 1;
+    uint16_t sample_bytes = (uint16_t)pcm_format_bytes(format);
+    uint16_t block_align = num_channels * sample_bytes;
+    unsigned char header[WAV_HEADER_SIZE];
+
+    // Sizes are placeholders until wav_writer_close
+    memcpy(header, "RIFF", 4);
+    put_u32(header + 4, WAV_HEADER_SIZE - 8);
+    memcpy(header + 8, "WAVE", 4);
+
+    memcpy(header + 12, "fmt ", 4);
+    put_u32(header + 16, 16);
+    put_u16(header + 20, format == PCM_FLOAT32 ? WAV_FORMAT_IEEE_FLOAT : WAV_FORMAT_PCM);
+    put_u16(header + 22, num_channels);
+    put_u32(header + 24, (uint32_t)sample_rate);
+    put_u32(header + 28, (uint32_t)sample_rate * block_align);
+    put_u16(header + 32, block_align);
+    put_u16(header + 34, sample_bytes * 8);
+
+    memcpy(header + 36, "data", 4);
+    put_u32(header + 40, 0);
+
+    writer->pcm = pcm_writer_open(filename, format, dither, header, sizeof(header));
+    if (!writer->pcm) {
+        free(writer);
+        return NULL;
     }
+    writer->sample_bytes = sample_bytes;
+    return writer;
+}
+
+WavWriter* wav_writer_open(const char* filename, int sample_rate) {
+    return wav_writer_open_format(filename, sample_rate, PCM_FLOAT32, false);
+}
+
+/**
+ * @brief Tells whether count more samples still fit in a RIFF file
+ * @return 0 if they fit, -1 (reported) otherwise
+ */
+static int wav_check_size(const WavWriter* writer, long count) {
+    unsigned long long samples = (unsigned long long)pcm_writer_samples(writer->pcm) +
+                                 (unsigned long long)count;
+    if (samples * (unsigned long long)writer->sample_bytes <= WAV_MAX_DATA_SIZE) return 0;
+    fprintf(stderr, "Error: WAV output exceeds the 4 GiB RIFF size limit "
+                    "(use RAW or FLAC for longer renders)\n");
+    return -1;
+}
+
+int wav_writer_write(WavWriter* writer, const float* samples, long count) {
+    if (wav_check_size(writer, count) != 0) return -1;
+    return pcm_writer_write(writer->pcm, samples, count);
+}
+
+int wav_writer_write_pcm24(WavWriter* writer, const int32_t* pcm, long count) {
+    if (wav_check_size(writer, count) != 0) return -1;
+    return pcm_writer_write_pcm24(writer->pcm, pcm, count);
+}
+
+int wav_writer_close(WavWriter* writer) {
+    if (!writer) return 0;
+
+    unsigned long long data_bytes = (unsigned long long)pcm_writer_samples(writer->pcm) *
+                                    (unsigned long long)writer->sample_bytes;
+    unsigned char size[4];
+    int status = 0;
+
+    // Writes past the limit are refused, so this only guards the header
+    if (data_bytes > WAV_MAX_DATA_SIZE) {
+        fprintf(stderr, "Error: WAV output exceeds the 4 GiB RIFF size limit\n");
+        pcm_writer_close(writer->pcm);
+        free(writer);
+        return -1;
+    }
+    uint32_t data_size = (uint32_t)data_bytes;
+
+    // RIFF chunks are word aligned; odd 24-bit data gets a pad byte
+    // that is not counted in the data size
+    if (data_size & 1) {
+        const unsigned char pad = 0;
+        if (pcm_writer_append(writer->pcm, &pad, 1) != 0) status = -1;
+    }
+
+    put_u32(size, WAV_HEADER_SIZE - 8 + data_size + (data_size & 1));
+    if (pcm_writer_patch(writer->pcm, WAV_RIFF_SIZE_OFFSET, size, 4) != 0) status = -1;
+    put_u32(size, data_size);
+    if (pcm_writer_patch(writer->pcm, WAV_DATA_SIZE_OFFSET, size, 4) != 0) status = -1;
+
+    if (pcm_writer_close(writer->pcm) != 0) status = -1;
+    free(writer);
+
+    return status;
+}
+
+void write_wav_file(const char* filename, float* buffer, long sample_count) {
+    WavWriter* writer = wav_writer_open(filename, SAMPLE_RATE);
+    if (!writer) return;
 
-    int16_t num_channels = 1;
-    int16_t bits_per_sample = 32;
-    int32_t sample_rate = SAMPLE_RATE;
-    int32_t byte_rate = sample_rate * num_channels * (bits_per_sample / 8);
-    int16_t block_align = num_channels * (bits_per_sample / 8);
-    int32_t subchunk2_size = sample_count * num_channels * (bits_per_sample / 8);
-    int32_t chunk_size = 36 + subchunk2_size;
-
-    fwrite("RIFF", 1, 4, fp);
-    fwrite(&chunk_size, 4, 1, fp);
-    fwrite("WAVE", 1, 4, fp);
-
-    fwrite("fmt ", 1, 4, fp);
-    int32_t subchunk1_size = 16;
-    fwrite(&subchunk1_size, 4, 1, fp);
-    int16_t audio_format = 3;
-    fwrite(&audio_format, 2, 1, fp);
-    fwrite(&num_channels, 2, 1, fp);
-    fwrite(&sample_rate, 4, 1, fp);
-    fwrite(&byte_rate, 4, 1, fp);
-    fwrite(&block_align, 2, 1, fp);
-    fwrite(&bits_per_sample, 2, 1, fp);
-
-    fwrite("data", 1, 4, fp);
-    fwrite(&subchunk2_size, 4, 1, fp);
-    fwrite(buffer, sizeof(float), sample_count, fp);
-
-    fclose(fp);
-}
\ No newline at end of file
+    wav_writer_write(writer, buffer, sample_count);
+    wav_writer_close(writer);
+}
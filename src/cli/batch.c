@@ -0,0 +1,283 @@
+/**
+ * @file batch.c
+ * @brief Compilation of many JSHL files in one process
+ * @author joaomrpimentel
+ * @version 1.3
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "batch.h"
+#include "compile_job.h"
+#include "audio_writer.h"
+#include "thread_pool.h"
+#include "diagnostics.h"
+#include "lexer.h"
+
+/**
+ * @brief One file of a batch
+ */
+typedef struct {
+    char* input_file;           /**< Source path */
+    char* output_file;          /**< Output path */
+    OutputFormat format;        /**< Output format */
+    long long source_size;      /**< Source size in bytes (-1 if unknown) */
+    const CliConfig* config;    /**< Shared options */
+    int status;                 /**< 0 once compiled, -1 on failure */
+    CompileResult result;       /**< Statistics of a successful compile */
+} BatchJob;
+
+/**
+ * @brief Growable list of jobs
+ */
+typedef struct {
+    BatchJob* jobs;
+    size_t size;
+    size_t capacity;
+} BatchList;
+
+/**
+ * @brief Derives the output path of an input without an explicit one
+ * @param output_dir Target directory (NULL = current directory)
+ * @param input_file Source path
+ * @param format Output format
+ * @return Newly allocated path, or NULL on allocation failure
+ *
+ * "dir/song.jshl" becomes "<output_dir>/song.<ext>".
+ */
+static char* default_output_path(const char* output_dir, const char* input_file,
+                                 OutputFormat format) {
+    const char* name = strrchr(input_file, '/');
+    name = name ? name + 1 : input_file;
+    const char* dot = strrchr(name, '.');
+    int stem = dot && dot != name ? (int)(dot - name) : (int)strlen(name);
+    const char* dir = output_dir ? output_dir : ".";
+    const char* ext = audio_format_extension(format);
+
+    size_t length = strlen(dir) + 1 + (size_t)stem + 1 + strlen(ext) + 1;
+    char* path = (char*)malloc(length);
+    if (!path) return NULL;
+    snprintf(path, length, "%s/%.*s.%s", dir, stem, name, ext);
+    return path;
+}
+
+/**
+ * @brief Appends a job
+ * @param list Target list
+ * @param config Shared options
+ * @param input_file Source path (copied)
+ * @param input_length Length of input_file
+ * @param output_file Explicit output path (copied), or NULL to derive one
+ * @param output_length Length of output_file
+ * @return 0 on success, -1 on allocation failure
+ */
+static int batch_add(BatchList* list, const CliConfig* config,
+                     const char* input_file, size_t input_length,
+                     const char* output_file, size_t output_length) {
+    if (list->size == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 16;
+        BatchJob* grown = (BatchJob*)realloc(list->jobs, capacity * sizeof(BatchJob));
+        if (!grown) return -1;
+        list->jobs = grown;
+        list->capacity = capacity;
+    }
+
+    BatchJob* job = &list->jobs[list->size];
+    job->config = config;
+    job->status = -1;
+    job->input_file = strndup(input_file, input_length);
+    if (!job->input_file) return -1;
+
+    if (output_file) {
+        job->output_file = strndup(output_file, output_length);
+        if (job->output_file) job->format = cli_output_format(config, job->output_file);
+    } else {
+        job->format = config->format;
+        job->output_file = default_output_path(config->output_dir, job->input_file,
+                                               job->format);
+    }
+    if (!job->output_file) {
+        free(job->input_file);
+        return -1;
+    }
+
+    struct stat st;
+    job->source_size = stat(job->input_file, &st) == 0 ? (long long)st.st_size : -1;
+    list->size++;
+    return 0;
+}
+
+/**
+ * @brief Reads the jobs of a manifest
+ * @param list Target list
+ * @param config Shared options (config->batch_file is read)
+ * @return 0 on success, -1 on error
+ */
+static int batch_read_manifest(BatchList* list, const CliConfig* config) {
+    Source manifest;
+    if (cli_source_open(&manifest, config->batch_file) != 0) return -1;
+
+    Lexer lexer;
+    Token tokens[LEXER_MAX_TOKENS];
+    int line;
+    int count;
+    int status = 0;
+    lexer_init(&lexer, manifest.data, manifest.size);
+
+    while (status == 0 && (count = lexer_next_line(&lexer, tokens, &line)) > 0) {
+        if (count > 2) {
+            fprintf(stderr, "Warning: Extra fields ignored at %s:%d\n",
+                    config->batch_file, line);
+        }
+        const char* input = manifest.data + tokens[0].offset;
+        const char* output = count > 1 ? manifest.data + tokens[1].offset : NULL;
+        status = batch_add(list, config, input, tokens[0].length,
+                           output, count > 1 ? tokens[1].length : 0);
+        if (status != 0) fprintf(stderr, "Error: Memory allocation failed\n");
+    }
+
+    source_close(&manifest);
+    return status;
+}
+
+/**
+ * @brief Orders jobs by decreasing source size
+ */
+static int compare_job_size(const void* a, const void* b) {
+    long long size_a = ((const BatchJob*)a)->source_size;
+    long long size_b = ((const BatchJob*)b)->source_size;
+    return (size_a < size_b) - (size_a > size_b);
+}
+
+/**
+ * @brief Orders job pointers by output path, then by position in the batch
+ */
+static int compare_job_output(const void* a, const void* b) {
+    const BatchJob* job_a = *(BatchJob* const*)a;
+    const BatchJob* job_b = *(BatchJob* const*)b;
+    int order = strcmp(job_a->output_file, job_b->output_file);
+    if (order != 0) return order;
+    return (job_a > job_b) - (job_a < job_b);
+}
+
+/**
+ * @brief Rejects jobs writing to an output already claimed by another job
+ * @param list Jobs of the batch
+ * @return 0 on success, -1 on allocation failure
+ *
+ * Two workers writing the same file would corrupt it; every job but the
+ * first one listed for a path is marked as failed instead.
+ */
+static int batch_claim_outputs(BatchList* list) {
+    BatchJob** order = (BatchJob**)malloc(list->size * sizeof(BatchJob*));
+    if (!order) return -1;
+    for (size_t i = 0; i < list->size; i++) order[i] = &list->jobs[i];
+    qsort(order, list->size, sizeof(BatchJob*), compare_job_output);
+
+    for (size_t i = 0; i < list->size; i++) order[i]->status = 0;
+    for (size_t i = 1; i < list->size; i++) {
+        if (strcmp(order[i]->output_file, order[i - 1]->output_file) != 0) continue;
+        order[i]->status = -1;
+        fprintf(stderr, "Error: '%s' and '%s' both write '%s'\n",
+                order[i - 1]->input_file, order[i]->input_file, order[i]->output_file);
+    }
+
+    free(order);
+    return 0;
+}
+
+/**
+ * @brief Worker task compiling one file
+ * @param arg BatchJob to run
+ */
+static void batch_job_task(void* arg) {
+    BatchJob* job = (BatchJob*)arg;
+    CompileOutput output = { job->output_file, job->format };
+    job->status = compile_job_run(job->config, job->input_file, &output, 1, &job->result);
+    if (job->status == 0 && job->result.note_count == 0) job->status = -1;
+}
+
+/**
+ * @brief Returns the monotonic clock in seconds
+ */
+static double batch_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void batch_free(BatchList* list) {
+    for (size_t i = 0; i < list->size; i++) {
+        free(list->jobs[i].input_file);
+        free(list->jobs[i].output_file);
+    }
+    free(list->jobs);
+}
+
+int batch_run(const CliConfig* config) {
+    BatchList list = { NULL, 0, 0 };
+
+    if (config->batch_file && batch_read_manifest(&list, config) != 0) {
+        batch_free(&list);
+        return -1;
+    }
+    for (int i = 0; i < config->input_count; i++) {
+        const char* input = config->input_files[i];
+        if (batch_add(&list, config, input, strlen(input), NULL, 0) != 0) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            batch_free(&list);
+            return -1;
+        }
+    }
+    if (list.size == 0) {
+        fprintf(stderr, "Error: No input files in batch\n");
+        batch_free(&list);
+        return -1;
+    }
+
+    // Outputs are claimed in listing order, then the largest sources start first
+    if (batch_claim_outputs(&list) != 0) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        batch_free(&list);
+        return -1;
+    }
+    qsort(list.jobs, list.size, sizeof(BatchJob), compare_job_size);
+
+    int workers = config->jobs > 0 ? config->jobs : thread_pool_cpu_count();
+    if ((size_t)workers > list.size) workers = (int)list.size;
+    if (config->verbose) {
+        printf("Compiling %zu file(s) on %d worker(s)\n", list.size, workers);
+    }
+
+    double start = batch_now();
+    ThreadPool* pool = workers > 1 ? thread_pool_create(workers) : NULL;
+    for (size_t i = 0; i < list.size; i++) {
+        BatchJob* job = &list.jobs[i];
+        if (job->status != 0) continue;
+        // Without a pool (one worker, or the pool failed) files run inline
+        if (!pool || thread_pool_submit(pool, batch_job_task, job) != 0) {
+            batch_job_task(job);
+        }
+    }
+    thread_pool_destroy(pool);
+    double elapsed = batch_now() - start;
+
+    size_t failed = 0;
+    double seconds = 0.0;
+    for (size_t i = 0; i < list.size; i++) {
+        if (list.jobs[i].status != 0) failed++;
+        else seconds += (double)list.jobs[i].result.total_samples / config->sample_rate;
+    }
+
+    printf("Batch: %zu compiled, %zu failed, %.2fs of audio in %.2fs\n",
+           list.size - failed, failed, seconds, elapsed);
+    for (size_t i = 0; i < list.size; i++) {
+        if (list.jobs[i].status != 0) fprintf(stderr, "  failed: %s\n", list.jobs[i].input_file);
+    }
+
+    batch_free(&list);
+    return (int)failed;
+}
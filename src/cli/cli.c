@@ -2,7 +2,7 @@
  * @file cli.c
  * @brief Command-line interface implementation
  * @author joaomrpimentel
- * @version 1.0
+ * @version 1.3
  */
 
 #include <stdio.h>
@@ -12,11 +12,32 @@
 #include <getopt.h>
 #include <ctype.h>
 #include "cli.h"
+#include "incremental.h"
+#include "output_cache.h"
 #include "jshl_compiler.h"
 
-#define VERSION "1.0.0"
 #define DEFAULT_OUTPUT "output.wav"
 
+/** Codes of options that only have a long form */
+enum {
+    OPT_FROM = 256,
+    OPT_TO,
+    OPT_CACHE_DIR,
+    OPT_CACHE_SIZE
+};
+
+/**
+ * @brief Parses a time in seconds
+ * @param text Option argument
+ * @param seconds Output value
+ * @return true if text is a non-negative number
+ */
+static bool parse_seconds(const char* text, double* seconds) {
+    char* end;
+    *seconds = strtod(text, &end);
+    return end != text && *end == '\0' && *seconds >= 0.0;
+}
+
 /**
  * @brief Determines output format from file extension
  * @param filename File path to analyze
@@ -28,25 +49,44 @@ static OutputFormat detect_format_from_extension(const char* filename) {
     
     if (strcmp(ext, ".wav") == 0) return FORMAT_WAV;
     if (strcmp(ext, ".raw") == 0 || strcmp(ext, ".pcm") == 0) return FORMAT_RAW;
+    if (strcmp(ext, ".flac") == 0) return FORMAT_FLAC;
+    if (strcmp(ext, ".mp3") == 0) return FORMAT_MP3;
     
     return FORMAT_UNKNOWN;
 }
 
 /**
  * @brief Parses format string to enum
- * @param format_str Format string ("wav", "raw")
+ * @param format_str Format string ("wav", "raw", "flac", "mp3")
  * @return Corresponding OutputFormat enum
  */
 static OutputFormat parse_format_string(const char* format_str) {
     if (strcasecmp(format_str, "wav") == 0) return FORMAT_WAV;
     if (strcasecmp(format_str, "raw") == 0) return FORMAT_RAW;
     if (strcasecmp(format_str, "pcm") == 0) return FORMAT_RAW;
+    if (strcasecmp(format_str, "flac") == 0) return FORMAT_FLAC;
+    if (strcasecmp(format_str, "mp3") == 0) return FORMAT_MP3;
     
     return FORMAT_UNKNOWN;
 }
 
+bool cli_is_batch(const CliConfig* config) {
+    return config->batch_file != NULL || config->output_dir != NULL;
+}
+
+OutputFormat cli_output_format(const CliConfig* config, const char* output_file) {
+    if (config->format_set) return config->format;
+    
+    // Auto-detect format from output filename if not explicitly set
+    OutputFormat detected = detect_format_from_extension(output_file);
+    return detected != FORMAT_UNKNOWN ? detected : config->format;
+}
+
 void cli_print_help(const char* program_name) {
-    printf("Usage: %s [OPTIONS] <input.jshl> [output]\n\n", program_name);
+    printf("Usage: %s [OPTIONS] <input.jshl> [output]\n", program_name);
+    printf("       %s [OPTIONS] -o OUT [-o OUT]... <input.jshl>\n", program_name);
+    printf("       %s [OPTIONS] -d DIR <input.jshl>...\n", program_name);
+    printf("       %s [OPTIONS] -b MANIFEST [-d DIR]\n\n", program_name);
     printf("JSHL Compiler - Converts JSHL music notation to audio files\n\n");
     
     printf("Arguments:\n");
@@ -54,21 +94,65 @@ void cli_print_help(const char* program_name) {
     printf("  [output]            Output audio file (default: output.wav)\n\n");
     
     printf("Options:\n");
-    printf("  -f, --format FORMAT Output format: wav, raw (default: wav)\n");
+    printf("  -o, --output FILE   Output file; repeat to write several formats from one\n");
+    printf("                      render (up to %d)\n", CLI_MAX_OUTPUTS);
+    printf("  -f, --format FORMAT Output format: wav, raw, flac, mp3 (default: wav)\n");
     printf("  -r, --rate RATE     Sample rate in Hz (default: %d)\n", SAMPLE_RATE);
+    printf("  -P, --preview       Quick draft: render at %d Hz (unless --rate is\n",
+           CLI_PREVIEW_SAMPLE_RATE);
+    printf("                      given) with cheaper oscillators\n");
+    printf("      --from SECONDS  Start rendering at this time (default: 0)\n");
+    printf("      --to SECONDS    Stop rendering at this time (default: end of song)\n");
+    printf("  -t, --threads N     Render and FLAC encoder threads, 0 = all CPUs\n");
+    printf("                      (default: 1)\n");
+    printf("  -p, --phase MODE    Oscillator phase at note-on: song, note (default: song)\n");
+    printf("  -l, --loop-clips    Render repeated LOOP iterations once and reuse them\n");
+    printf("                      (implies --phase note)\n");
+    printf("  -c, --note-cache MB Reuse rendered notes, up to MB of samples (default: off)\n");
+    printf("  -i, --incremental   Keep the render next to the first output (OUTPUT%s)\n",
+           INCREMENTAL_CACHE_EXTENSION);
+    printf("                      and synthesize only what changed since then\n");
+    printf("      --cache-dir DIR Reuse outputs of identical songs and settings from DIR\n");
+    printf("      --cache-size MB Size limit of --cache-dir, least recently used files\n");
+    printf("                      are deleted first (default: %d)\n", OUTPUT_CACHE_DEFAULT_MB);
+    printf("  -B, --bits N        WAV/RAW sample format: 16, 24 (integer) or 32 (float)\n");
+    printf("                      (default: 32)\n");
+    printf("  -D, --dither        Add triangular dither to 16/24-bit WAV/RAW output\n");
+    printf("  -b, --batch FILE    Compile every file listed in FILE, one per line:\n");
+    printf("                      <input.jshl> [output]\n");
+    printf("  -d, --output-dir DIR\n");
+    printf("                      Compile all inputs, writing DIR/<name>.<format>\n");
+    printf("  -j, --jobs N        Files compiled at once in batch mode, 0 = all CPUs\n");
+    printf("                      (default: 0)\n");
     printf("  -v, --verbose       Enable verbose output\n");
     printf("  -h, --help          Show this help message\n");
     printf("  -V, --version       Show version information\n\n");
     
     printf("Formats:\n");
-    printf("  wav                 WAV file with RIFF header (32-bit float PCM)\n");
-    printf("  raw                 Raw PCM data, 32-bit float, no header\n\n");
+    printf("  wav                 WAV file with RIFF header (PCM, see --bits)\n");
+    printf("  raw                 Raw little-endian PCM data, no header (see --bits)\n");
+    printf("  flac                FLAC lossless, 24-bit, compression level 8\n");
+    printf("  mp3                 MP3, 320 kbps CBR\n\n");
     
     printf("Examples:\n");
     printf("  %s song.jshl                    # Compile to output.wav\n", program_name);
     printf("  %s song.jshl music.wav          # Compile to music.wav\n", program_name);
     printf("  %s -f raw song.jshl audio.raw   # Output raw PCM data\n", program_name);
     printf("  %s -r 48000 song.jshl           # Use 48kHz sample rate\n", program_name);
+    printf("  %s -P song.jshl draft.wav       # Fast low-rate preview\n", program_name);
+    printf("  %s --from 62.5 --to 75 song.jshl\n", program_name);
+    printf("                                      # Render only 1:02.5 to 1:15\n");
+    printf("  %s -t 0 song.jshl               # Render on all CPU cores\n", program_name);
+    printf("  %s -B 16 -D song.jshl           # Dithered 16-bit WAV\n", program_name);
+    printf("  %s -o a.wav -o a.flac -o a.mp3 song.jshl\n", program_name);
+    printf("                                      # Render once, encode three formats\n");
+    printf("  %s -i song.jshl                 # Recompile only the edited part\n", program_name);
+    printf("  %s --cache-dir ~/.cache/jshl -b tracks.txt\n", program_name);
+    printf("                                      # Skip tracks compiled before\n");
+    printf("  %s -l song.jshl                 # Reuse rendered loop iterations\n", program_name);
+    printf("  %s -p note -c 64 song.jshl      # Cache repeated notes in 64 MB\n", program_name);
+    printf("  %s -d out/ -f flac *.jshl       # Compile many files to out/*.flac\n", program_name);
+    printf("  %s -b tracks.txt -j 8           # Compile a manifest on 8 workers\n", program_name);
     printf("  %s -v song.jshl                 # Verbose compilation\n\n", program_name);
     
     printf("JSHL Language:\n");
@@ -83,26 +167,60 @@ void cli_print_help(const char* program_name) {
 }
 
 void cli_print_version(void) {
-    printf("JSHL Compiler v%s\n", VERSION);
+    printf("JSHL Compiler v%s\n", CLI_VERSION);
     printf("Build date: %s %s\n", __DATE__, __TIME__);
-    printf("Sample rate: %d Hz\n", SAMPLE_RATE);
+    printf("Default sample rate: %d Hz\n", SAMPLE_RATE);
     printf("Copyright (c) 2025 - MIT License\n");
 }
 
 bool cli_parse_args(int argc, char* argv[], CliConfig* config) {
     // Initialize defaults
     config->input_file = NULL;
-    config->output_file = DEFAULT_OUTPUT;
+    config->output_count = 0;
     config->format = FORMAT_WAV;
+    config->format_set = false;
+    config->batch_file = NULL;
+    config->output_dir = NULL;
+    config->input_files = NULL;
+    config->input_count = 0;
+    config->jobs = 0;
     config->sample_rate = SAMPLE_RATE;
+    config->preview = false;
+    config->range_from = 0.0;
+    config->range_to = -1.0;
+    config->incremental = false;
+    config->cache_dir = NULL;
+    config->cache_size_mb = OUTPUT_CACHE_DEFAULT_MB;
+    config->threads = 1;
+    config->phase = VOICE_PHASE_GLOBAL;
+    config->loop_clips = false;
+    config->note_cache_mb = 0;
+    config->pcm_format = PCM_FLOAT32;
+    config->dither = false;
     config->verbose = false;
     config->show_help = false;
     config->show_version = false;
     
     // Define long options
     static struct option long_options[] = {
+        {"output",  required_argument, 0, 'o'},
         {"format",  required_argument, 0, 'f'},
         {"rate",    required_argument, 0, 'r'},
+        {"preview", no_argument,       0, 'P'},
+        {"from",    required_argument, 0, OPT_FROM},
+        {"to",      required_argument, 0, OPT_TO},
+        {"threads", required_argument, 0, 't'},
+        {"phase",   required_argument, 0, 'p'},
+        {"loop-clips", no_argument,    0, 'l'},
+        {"note-cache", required_argument, 0, 'c'},
+        {"incremental", no_argument,   0, 'i'},
+        {"cache-dir", required_argument, 0, OPT_CACHE_DIR},
+        {"cache-size", required_argument, 0, OPT_CACHE_SIZE},
+        {"bits",    required_argument, 0, 'B'},
+        {"dither",  no_argument,       0, 'D'},
+        {"batch",   required_argument, 0, 'b'},
+        {"output-dir", required_argument, 0, 'd'},
+        {"jobs",    required_argument, 0, 'j'},
         {"verbose", no_argument,       0, 'v'},
         {"help",    no_argument,       0, 'h'},
         {"version", no_argument,       0, 'V'},
@@ -111,15 +229,25 @@ bool cli_parse_args(int argc, char* argv[], CliConfig* config) {
     
     int opt;
     int option_index = 0;
+    bool rate_set = false;
     
     // Parse options
-    while ((opt = getopt_long(argc, argv, "f:r:vhV", long_options, &option_index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "o:f:r:Pt:p:lc:iB:Db:d:j:vhV", long_options, &option_index)) != -1) {
         switch (opt) {
+            case 'o':
+                if (config->output_count == CLI_MAX_OUTPUTS) {
+                    fprintf(stderr, "Error: At most %d outputs are supported\n", CLI_MAX_OUTPUTS);
+                    return false;
+                }
+                config->output_files[config->output_count++] = optarg;
+                break;
+                
             case 'f':
                 config->format = parse_format_string(optarg);
+                config->format_set = true;
                 if (config->format == FORMAT_UNKNOWN) {
                     fprintf(stderr, "Error: Unknown format '%s'\n", optarg);
-                    fprintf(stderr, "Supported formats: wav, raw\n");
+                    fprintf(stderr, "Supported formats: wav, raw, flac, mp3\n");
                     return false;
                 }
                 break;
@@ -130,6 +258,101 @@ bool cli_parse_args(int argc, char* argv[], CliConfig* config) {
                     fprintf(stderr, "Error: Sample rate must be between 8000 and 192000 Hz\n");
                     return false;
                 }
+                rate_set = true;
+                break;
+                
+            case 'P':
+                config->preview = true;
+                break;
+                
+            case OPT_FROM:
+                if (!parse_seconds(optarg, &config->range_from)) {
+                    fprintf(stderr, "Error: Invalid start time '%s'\n", optarg);
+                    return false;
+                }
+                break;
+                
+            case OPT_TO:
+                if (!parse_seconds(optarg, &config->range_to)) {
+                    fprintf(stderr, "Error: Invalid end time '%s'\n", optarg);
+                    return false;
+                }
+                break;
+                
+            case 't':
+                config->threads = atoi(optarg);
+                if (config->threads < 0 || config->threads > 1024) {
+                    fprintf(stderr, "Error: Thread count must be between 0 and 1024\n");
+                    return false;
+                }
+                break;
+                
+            case 'p':
+                if (strcasecmp(optarg, "song") == 0) {
+                    config->phase = VOICE_PHASE_GLOBAL;
+                } else if (strcasecmp(optarg, "note") == 0) {
+                    config->phase = VOICE_PHASE_NOTE;
+                } else {
+                    fprintf(stderr, "Error: Unknown phase mode '%s'\n", optarg);
+                    fprintf(stderr, "Supported modes: song, note\n");
+                    return false;
+                }
+                break;
+                
+            case 'l':
+                config->loop_clips = true;
+                config->phase = VOICE_PHASE_NOTE;
+                break;
+                
+            case 'c':
+                config->note_cache_mb = atoi(optarg);
+                if (config->note_cache_mb < 0 || config->note_cache_mb > 65536) {
+                    fprintf(stderr, "Error: Note cache size must be between 0 and 65536 MB\n");
+                    return false;
+                }
+                break;
+                
+            case 'i':
+                config->incremental = true;
+                break;
+                
+            case OPT_CACHE_DIR:
+                config->cache_dir = optarg;
+                break;
+                
+            case OPT_CACHE_SIZE:
+                config->cache_size_mb = atoi(optarg);
+                if (config->cache_size_mb < 1 || config->cache_size_mb > 1048576) {
+                    fprintf(stderr, "Error: Cache size must be between 1 and 1048576 MB\n");
+                    return false;
+                }
+                break;
+                
+            case 'B':
+                if (!pcm_format_from_bits(atoi(optarg), &config->pcm_format)) {
+                    fprintf(stderr, "Error: Bit depth must be 16, 24 or 32\n");
+                    return false;
+                }
+                break;
+                
+            case 'D':
+                config->dither = true;
+                break;
+                
+            case 'b':
+                config->batch_file = optarg;
+                break;
+                
+            case 'd':
+                config->output_dir = optarg;
+                break;
+                
+            case 'j':
+                config->jobs = atoi(optarg);
+                if (config->jobs < 0 || config->jobs > 1024) {
+                    fprintf(stderr, "Error: Job count must be between 0 and 1024\n");
+                    return false;
+                }
                 break;
                 
             case 'v':
@@ -153,34 +376,84 @@ bool cli_parse_args(int argc, char* argv[], CliConfig* config) {
         }
     }
     
-    // Parse positional arguments
-    int remaining_args = argc - optind;
-    
-    if (remaining_args < 1) {
-        fprintf(stderr, "Error: No input file specified\n");
-        fprintf(stderr, "Try '%s --help' for more information.\n", argv[0]);
+    if (config->preview && !rate_set) config->sample_rate = CLI_PREVIEW_SAMPLE_RATE;
+    if (config->range_to >= 0.0 && config->range_to <= config->range_from) {
+        fprintf(stderr, "Error: --to must be later than --from\n");
+        return false;
+    }
+    if (config->incremental && config->loop_clips) {
+        // Clips change the summation order, so reused and new samples could differ
+        fprintf(stderr, "Error: --incremental cannot be combined with --loop-clips\n");
+        return false;
+    }
+    if (config->incremental && (config->range_from > 0.0 || config->range_to >= 0.0)) {
+        fprintf(stderr, "Error: --incremental cannot be combined with --from or --to\n");
         return false;
     }
     
-    config->input_file = argv[optind];
+    // Parse positional arguments
+    int remaining_args = argc - optind;
     
-    if (remaining_args >= 2) {
-        config->output_file = argv[optind + 1];
+    if (cli_is_batch(config)) {
+        if (config->output_count > 0) {
+            fprintf(stderr, "Error: --output cannot be combined with --batch or --output-dir\n");
+            return false;
+        }
+        
+        // Every positional argument is an input
+        config->input_files = argv + optind;
+        config->input_count = remaining_args;
+        if (!config->batch_file && remaining_args < 1) {
+            fprintf(stderr, "Error: No input file specified\n");
+            fprintf(stderr, "Try '%s --help' for more information.\n", argv[0]);
+            return false;
+        }
+    } else {
+        if (remaining_args < 1) {
+            fprintf(stderr, "Error: No input file specified\n");
+            fprintf(stderr, "Try '%s --help' for more information.\n", argv[0]);
+            return false;
+        }
+        if (remaining_args > 2) {
+            fprintf(stderr, "Error: Several input files need --output-dir or --batch\n");
+            fprintf(stderr, "Try '%s --help' for more information.\n", argv[0]);
+            return false;
+        }
+        
+        config->input_file = argv[optind];
+        config->input_files = argv + optind;
+        config->input_count = 1;
+        
+        if (remaining_args >= 2) {
+            if (config->output_count == CLI_MAX_OUTPUTS) {
+                fprintf(stderr, "Error: At most %d outputs are supported\n", CLI_MAX_OUTPUTS);
+                return false;
+            }
+            config->output_files[config->output_count++] = argv[optind + 1];
+        }
+        if (config->output_count == 0) {
+            config->output_files[config->output_count++] = DEFAULT_OUTPUT;
+        }
         
-        // Auto-detect format from output filename if not explicitly set
-        if (opt == -1) {  // No -f option was used
-            OutputFormat detected = detect_format_from_extension(config->output_file);
-            if (detected != FORMAT_UNKNOWN) {
-                config->format = detected;
+        // The same file twice would be written by two encoders at once
+        for (int i = 0; i < config->output_count; i++) {
+            for (int j = 0; j < i; j++) {
+                if (strcmp(config->output_files[i], config->output_files[j]) == 0) {
+                    fprintf(stderr, "Error: Output '%s' given twice\n", config->output_files[i]);
+                    return false;
+                }
             }
         }
+        config->format = cli_output_format(config, config->output_files[0]);
     }
     
-    // Validate input file extension
-    const char* ext = strrchr(config->input_file, '.');
-    if (!ext || strcmp(ext, ".jshl") != 0) {
-        fprintf(stderr, "Warning: Input file '%s' doesn't have .jshl extension\n", 
-                config->input_file);
+    // Validate input file extensions
+    for (int i = 0; i < config->input_count; i++) {
+        const char* ext = strrchr(config->input_files[i], '.');
+        if (!ext || strcmp(ext, ".jshl") != 0) {
+            fprintf(stderr, "Warning: Input file '%s' doesn't have .jshl extension\n", 
+                    config->input_files[i]);
+        }
     }
     
     return true;
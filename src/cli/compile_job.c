@@ -0,0 +1,394 @@
+/**
+ * @file compile_job.c
+ * @brief Compilation of one JSHL file to audio files
+ * @author joaomrpimentel
+ * @version 1.7
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "compile_job.h"
+#include "note_list.h"
+#include "parser.h"
+#include "synth.h"
+#include "audio_writer.h"
+#include "dsp.h"
+#include "thread_pool.h"
+#include "arena.h"
+#include "source.h"
+#include "chunk_queue.h"
+#include "incremental.h"
+#include "output_cache.h"
+#include "diagnostics.h"
+
+/** Samples rendered and written per streaming step */
+#define STREAM_CHUNK_FRAMES 65536
+
+/** Chunks the renderer may run ahead of the encoder */
+#define PIPELINE_DEPTH 4
+
+/**
+ * @brief Encoder side of the render pipeline, one per output
+ */
+typedef struct {
+    ChunkQueue* queue;      /**< Rendered chunks */
+    int consumer;           /**< Consumer index in the queue */
+    int output;             /**< Index of the output it writes */
+    AudioWriter writer;     /**< Open output */
+    bool shared_pcm24;      /**< Encode from the chunk's shared 24-bit conversion */
+    int status;             /**< 0, or -1 after a write error */
+    pthread_t thread;
+} EncoderTask;
+
+/**
+ * @brief Encoder thread: writes chunks until the queue is drained
+ * @param arg EncoderTask
+ * @return Always NULL
+ *
+ * On a write error the encoder detaches, so neither the renderer nor the
+ * other outputs wait for it.
+ */
+static void* encoder_main(void* arg) {
+    EncoderTask* task = (EncoderTask*)arg;
+    const Chunk* chunk;
+
+    while ((chunk = chunk_queue_pop(task->queue, task->consumer)) != NULL) {
+        int status = task->shared_pcm24
+                   ? audio_writer_write_pcm24(&task->writer, chunk->pcm24, chunk->frames)
+                   : audio_writer_write(&task->writer, chunk->samples, chunk->frames);
+        chunk_queue_release(task->queue, task->consumer);
+        if (status != 0) {
+            task->status = -1;
+            chunk_queue_detach(task->queue, task->consumer);
+            break;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Streams a rendered note list into one or more output files
+ * @param list Parsed notes
+ * @param options Rendering options
+ * @param writer_options Encoder options shared by every output
+ * @param range_from First sample to render
+ * @param range_to One past the last sample to render (< 0 = song end)
+ * @param cache_path Render cache for incremental recompilation (NULL = off)
+ * @param outputs Files to write
+ * @param output_count Number of outputs
+ * @param total_samples Output parameter for the number of samples rendered
+ * @param synthesized Output parameter for how many of them were synthesized
+ *        (the others were reused from the render cache)
+ * @param failed Output array: failed[i] is set for outputs that failed
+ * @return 0 if every output was written, -1 otherwise
+ *
+ * The renderer and one encoder thread per output are connected by a
+ * queue of PIPELINE_DEPTH chunks: while the encoders compress one chunk
+ * the renderer synthesizes the next ones, and blocks once it is that far
+ * ahead of the slowest encoder. Wall time approaches the slowest stage
+ * instead of the sum of all of them, with at most PIPELINE_DEPTH chunks
+ * held in memory. When several outputs are encoded from 24-bit integers
+ * the renderer converts each chunk once for all of them.
+ *
+ * A range starting past zero is reached with synth_stream_seek, so only
+ * the notes sounding inside it are synthesized. With a render cache the
+ * samples come from incremental_read instead, which synthesizes only the
+ * span changed since the cached render.
+ */
+static int render_to_files(const NoteList* list, const SynthOptions* options,
+                           const AudioWriterOptions* writer_options,
+                           long range_from, long range_to, const char* cache_path,
+                           const CompileOutput* outputs, int output_count,
+                           long* total_samples, long* synthesized, bool* failed) {
+    SynthStream stream;
+    IncrementalRender incremental;
+    EncoderTask encoders[CLI_MAX_OUTPUTS];
+    int encoder_count = 0;
+    int pcm24_count = 0;
+    int status = 0;
+
+    *total_samples = 0;
+    *synthesized = 0;
+    for (int i = 0; i < output_count; i++) failed[i] = true;
+    if (synth_stream_init(&stream, list, options) != 0) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return -1;
+    }
+
+    long end = range_to >= 0 && range_to < stream.total_samples ? range_to : stream.total_samples;
+    if (range_from >= end) {
+        fprintf(stderr, "Error: Range starts after the end of the song (%.2fs)\n",
+                (double)stream.total_samples / options->sample_rate);
+        synth_stream_free(&stream);
+        return -1;
+    }
+    if (synth_stream_seek(&stream, range_from) != 0) {
+        fprintf(stderr, "Error: Voice allocation failed\n");
+        synth_stream_free(&stream);
+        return -1;
+    }
+    if (cache_path && incremental_open(&incremental, cache_path, list, &stream) != 0) {
+        synth_stream_free(&stream);
+        return -1;
+    }
+
+    // An output that cannot be created is skipped; the others still run
+    for (int i = 0; i < output_count; i++) {
+        EncoderTask* encoder = &encoders[encoder_count];
+        if (audio_writer_open_with_options(&encoder->writer, outputs[i].format,
+                                           outputs[i].file, options->sample_rate,
+                                           writer_options) != 0) {
+            status = -1;
+            continue;
+        }
+        encoder->output = i;
+        encoder->consumer = encoder_count++;
+        encoder->status = 0;
+        if (audio_writer_uses_pcm24(&encoder->writer)) pcm24_count++;
+    }
+    if (encoder_count == 0) {
+        if (cache_path) incremental_close(&incremental, false);
+        synth_stream_free(&stream);
+        return -1;
+    }
+
+    bool share_pcm24 = pcm24_count > 1;
+    ChunkQueue* queue = chunk_queue_create(PIPELINE_DEPTH, STREAM_CHUNK_FRAMES,
+                                           encoder_count, share_pcm24);
+    int started = 0;
+    bool rendered = false;
+    if (!queue) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+    } else {
+        for (; started < encoder_count; started++) {
+            EncoderTask* encoder = &encoders[started];
+            encoder->queue = queue;
+            encoder->shared_pcm24 = share_pcm24 && audio_writer_uses_pcm24(&encoder->writer);
+            if (pthread_create(&encoder->thread, NULL, encoder_main, encoder) != 0) {
+                fprintf(stderr, "Error: Cannot start encoder thread\n");
+                chunk_queue_abort(queue);
+                break;
+            }
+        }
+    }
+
+    if (queue && started == encoder_count) {
+        Chunk* chunk;
+        while ((chunk = chunk_queue_acquire(queue)) != NULL) {
+            long wanted = end - stream.position;
+            if (wanted > STREAM_CHUNK_FRAMES) wanted = STREAM_CHUNK_FRAMES;
+            long frames = cache_path
+                        ? incremental_read(&incremental, &stream, chunk->samples, wanted)
+                        : synth_stream_read(&stream, chunk->samples, wanted);
+            if (frames < 0) {
+                fprintf(stderr, "Error: Voice allocation failed\n");
+                chunk_queue_abort(queue);
+                break;
+            }
+            if (frames == 0) {
+                rendered = true;
+                break;
+            }
+            if (share_pcm24) {
+                dsp_kernels()->float_to_int(chunk->samples, chunk->pcm24, frames, INT24_SCALE);
+            }
+            chunk->frames = frames;
+            chunk_queue_push(queue);
+            *total_samples += frames;
+        }
+        // Every encoder gave up: there is nothing left to render for
+        if (!chunk) rendered = true;
+        chunk_queue_close(queue);
+    }
+
+    for (int i = 0; i < started; i++) pthread_join(encoders[i].thread, NULL);
+
+    for (int i = 0; i < encoder_count; i++) {
+        EncoderTask* encoder = &encoders[i];
+        bool ok = rendered && encoder->status == 0;
+        if (audio_writer_close(&encoder->writer) != 0) ok = false;
+        failed[encoder->output] = !ok;
+        if (!ok) status = -1;
+    }
+
+    chunk_queue_destroy(queue);
+    if (cache_path) {
+        // A cache that cannot be saved only costs the next compilation time
+        *synthesized = incremental.render_to - incremental.render_from;
+        incremental_close(&incremental, rendered);
+    } else {
+        *synthesized = *total_samples;
+    }
+    synth_stream_free(&stream);
+
+    return status;
+}
+
+int compile_job_run(const CliConfig* config, const char* input_file,
+                    const CompileOutput* outputs, int output_count,
+                    CompileResult* result) {
+    result->note_count = 0;
+    result->total_samples = 0;
+    result->failed_outputs = 0;
+
+    Source source;
+    if (cli_source_open(&source, input_file) != 0) return -1;
+
+    // Notes, IR and parser scratch share one arena, released in one go
+    Arena arena;
+    NoteList note_list;
+    LoopList loops;
+    Program program;
+    arena_init(&arena, 0);
+    loop_list_init(&loops);
+    if (note_list_init_arena(&note_list, &arena) != 0 ||
+        program_init_arena(&program, &arena) != 0) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        source_close(&source);
+        arena_free(&arena);
+        return -1;
+    }
+    program.report = diagnostics_print;
+    if (parse_jshl_source(source.data, source.size, &program) != 0 ||
+        program_execute_loops(&program, &note_list, config->loop_clips ? &loops : NULL) != 0) {
+        fprintf(stderr, "Error: Failed to compile '%s'\n", input_file);
+        source_close(&source);
+        loop_list_free(&loops);
+        arena_free(&arena);
+        return -1;
+    }
+    source_close(&source);
+
+    SynthOptions synth_options;
+    synth_options_init(&synth_options);
+    synth_options.threads = config->threads;
+    synth_options.phase = config->phase;
+    synth_options.sample_rate = config->sample_rate;
+    synth_options.draft = config->preview;
+    if (config->loop_clips) synth_options.loops = &loops;
+    if (config->note_cache_mb > 0) {
+        synth_options.note_cache = note_cache_create((size_t)config->note_cache_mb << 20);
+        if (!synth_options.note_cache) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            loop_list_free(&loops);
+            arena_free(&arena);
+            return -1;
+        }
+    }
+
+    if (config->verbose) {
+        printf("Parsed %zu notes from '%s'\n", note_list.size, input_file);
+        printf("Rendering at %d Hz%s with %d thread(s)\n", config->sample_rate,
+               config->preview ? " (preview)" : "",
+               config->threads > 0 ? config->threads : thread_pool_cpu_count());
+        if (config->range_to >= 0.0) {
+            printf("Range: %.3fs to %.3fs\n", config->range_from, config->range_to);
+        } else if (config->range_from > 0.0) {
+            printf("Range: %.3fs to end\n", config->range_from);
+        }
+        if (config->loop_clips) printf("Found %zu loop(s)\n", loops.size);
+    }
+
+    int status = 0;
+    if (note_list.size > 0) {
+        long total_samples = 0;
+        long synthesized = 0;
+        bool failed[CLI_MAX_OUTPUTS];
+        AudioWriterOptions writer_options;
+        audio_writer_options_init(&writer_options);
+        writer_options.threads = config->threads;
+        writer_options.pcm_format = config->pcm_format;
+        writer_options.dither = config->dither;
+        long range_from = (long)(config->range_from * config->sample_rate);
+        long range_to = config->range_to >= 0.0
+                      ? (long)(config->range_to * config->sample_rate) : -1;
+
+        // Outputs found in the output cache are copied, the others rendered
+        OutputCacheKey keys[CLI_MAX_OUTPUTS];
+        CompileOutput pending[CLI_MAX_OUTPUTS];
+        int pending_output[CLI_MAX_OUTPUTS];
+        int pending_count = 0;
+        int reused = 0;
+        for (int i = 0; i < output_count; i++) {
+            int hit = 0;
+            failed[i] = false;
+            if (config->cache_dir) {
+                output_cache_key(&keys[i], &note_list, config, outputs[i].format);
+                hit = output_cache_fetch(config->cache_dir, &keys[i], outputs[i].format,
+                                         outputs[i].file);
+            }
+            if (hit > 0) {
+                reused++;
+            } else if (hit < 0) {
+                failed[i] = true;
+                status = -1;
+            } else {
+                pending_output[pending_count] = i;
+                pending[pending_count++] = outputs[i];
+            }
+        }
+        if (config->verbose && config->cache_dir) {
+            printf("Output cache: %d of %d output(s) reused\n", reused, output_count);
+        }
+
+        if (pending_count == 0) {
+            long length = synth_song_length(&note_list, config->sample_rate);
+            total_samples = (range_to >= 0 && range_to < length ? range_to : length) - range_from;
+        } else {
+            // The cache sits next to the first output, so each output set has its own
+            char cache_path[4096];
+            bool pending_failed[CLI_MAX_OUTPUTS];
+            bool cached = config->incremental &&
+                          snprintf(cache_path, sizeof(cache_path), "%s%s", outputs[0].file,
+                                   INCREMENTAL_CACHE_EXTENSION) < (int)sizeof(cache_path);
+            if (render_to_files(&note_list, &synth_options, &writer_options,
+                                range_from, range_to, cached ? cache_path : NULL,
+                                pending, pending_count, &total_samples, &synthesized,
+                                pending_failed) != 0) {
+                status = -1;
+            }
+            if (config->verbose && cached) {
+                printf("Render cache: synthesized %.2fs, reused %.2fs\n",
+                       (double)synthesized / config->sample_rate,
+                       (double)(total_samples - synthesized) / config->sample_rate);
+            }
+            for (int p = 0; p < pending_count; p++) {
+                int i = pending_output[p];
+                failed[i] = pending_failed[p];
+                if (!failed[i] && config->cache_dir) {
+                    output_cache_store(config->cache_dir, (size_t)config->cache_size_mb << 20,
+                                       &keys[i], outputs[i].format, outputs[i].file);
+                }
+            }
+        }
+        result->note_count = note_list.size;
+        result->total_samples = total_samples;
+        for (int i = 0; i < output_count; i++) {
+            if (failed[i]) {
+                fprintf(stderr, "Error: Failed to write '%s'\n", outputs[i].file);
+                result->failed_outputs++;
+            } else {
+                printf("Compiled: %zu notes, %.2fs → %s\n",
+                       note_list.size,
+                       (float)total_samples / config->sample_rate,
+                       outputs[i].file);
+            }
+        }
+    } else {
+        fprintf(stderr, "Error: No notes to render in '%s'\n", input_file);
+    }
+
+    if (status == 0 && config->verbose && synth_options.note_cache) {
+        const NoteCacheStats* stats = &synth_options.note_cache->stats;
+        printf("Note cache: %zu hits, %zu misses, %zu evictions, %zu bypassed\n",
+               stats->hits, stats->misses, stats->evictions, stats->bypassed);
+    }
+
+    loop_list_free(&loops);
+    arena_free(&arena);
+    note_cache_destroy(synth_options.note_cache);
+
+    return status;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file diagnostics.c
+ * @brief Error reporting for the command-line tools
+ * @author joaomrpimentel
+ * @version 1.1
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "diagnostics.h"
+#include "note_list.h"
+#include "parser.h"
+
+void diagnostics_print(const char* format, va_list args) {
+    vfprintf(stderr, format, args);
+}
+
+int cli_source_open(Source* source, const char* path) {
+    int status = source_map(source, path);
+    if (status != 0) fprintf(stderr, "Error: Cannot read file '%s'\n", path);
+    return status;
+}
+
+void cli_note_list_init(NoteList* list) {
+    if (note_list_init_arena(list, NULL) != 0) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(1);
+    }
+}
+
+void cli_note_list_add(NoteList* list, NoteEvent note) {
+    if (note_list_push(list, note) != 0) {
+        fprintf(stderr, "Error: Memory reallocation failed\n");
+        exit(1);
+    }
+}
+
+void cli_program_init(Program* program) {
+    if (program_init_arena(program, NULL) != 0) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(1);
+    }
+    program->report = diagnostics_print;
+}
+
+void cli_parse_jshl(char* code, NoteList* list) {
+    Program program;
+    cli_program_init(&program);
+    if (parse_jshl_program(code, &program) != 0 ||
+        program_execute(&program, list) != 0) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        exit(1);
+    }
+    program_free(&program);
+}
@@ -0,0 +1,286 @@
+/**
+ * @file incremental.c
+ * @brief Incremental recompilation through a sidecar render cache
+ * @author joaomrpimentel
+ * @version 1.1
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include "incremental.h"
+#include "note_list.h"
+#include "voice.h"
+
+/** Identifies a render cache file */
+#define CACHE_MAGIC "JSHLRC\r\n"
+
+/** Bumped whenever the layout or the meaning of the samples changes */
+#define CACHE_VERSION 1
+
+/**
+ * @brief Start of a cache file
+ *
+ * The header is followed by total_samples clipped float samples and
+ * note_count CachedNote records, all in native byte order: the cache is
+ * a local file, not an exchange format.
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    int32_t sample_rate;
+    int32_t phase;
+    int32_t draft;
+    int64_t total_samples;
+    int64_t note_count;
+} CacheHeader;
+
+/**
+ * @brief Reads note i of the old cache (records may be unaligned)
+ */
+static void old_note(const IncrementalRender* render, size_t i, CachedNote* note) {
+    const char* records = (const char*)(render->old_samples + render->old_total);
+    memcpy(note, records + i * sizeof(CachedNote), sizeof(CachedNote));
+}
+
+/**
+ * @brief Maps the previous cache if it matches the stream's settings
+ * @return Number of notes in it (0 if there is no usable cache)
+ */
+static size_t load_previous(IncrementalRender* render, const SynthStream* stream) {
+    CacheHeader header;
+    render->old_samples = NULL;
+    render->old_total = 0;
+    if (source_map(&render->previous, render->path) != 0) {
+        render->previous.data = NULL;
+        return 0;
+    }
+
+    const Source* file = &render->previous;
+    bool usable = file->size >= sizeof(CacheHeader);
+    if (usable) {
+        memcpy(&header, file->data, sizeof(CacheHeader));
+        size_t payload = file->size - sizeof(CacheHeader);
+        usable = memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+                 header.version == CACHE_VERSION &&
+                 header.sample_rate == stream->sample_rate &&
+                 header.phase == (int32_t)stream->phase &&
+                 header.draft == (int32_t)stream->draft &&
+                 header.total_samples >= 0 && header.note_count >= 0 &&
+                 (uint64_t)header.total_samples <= payload / sizeof(float) &&
+                 (uint64_t)header.note_count <= payload / sizeof(CachedNote) &&
+                 header.total_samples * sizeof(float) +
+                     header.note_count * sizeof(CachedNote) == payload;
+    }
+    if (!usable) {
+        source_close(&render->previous);
+        render->previous.data = NULL;
+        return 0;
+    }
+
+    render->old_samples = (const float*)(file->data + sizeof(CacheHeader));
+    render->old_total = (long)header.total_samples;
+    return (size_t)header.note_count;
+}
+
+static bool same_note(const CachedNote* old, const CachedNote* now, long shift) {
+    return now->hash == old->hash && now->start == old->start + shift &&
+           now->end == old->end + shift;
+}
+
+/**
+ * @brief Computes the span that must be synthesized
+ * @param render Render with the new notes and the old cache loaded
+ * @param old_count Notes in the old cache
+ */
+static void plan_span(IncrementalRender* render, size_t old_count) {
+    size_t new_count = render->note_count;
+    size_t common = old_count < new_count ? old_count : new_count;
+    CachedNote old;
+
+    size_t prefix = 0;
+    while (prefix < common) {
+        old_note(render, prefix, &old);
+        if (!same_note(&old, &render->notes[prefix], 0)) break;
+        prefix++;
+    }
+
+    // Notes after the edit move by the offset of the last one
+    long shift = 0;
+    size_t suffix = 0;
+    if (prefix < common) {
+        old_note(render, old_count - 1, &old);
+        shift = (long)(render->notes[new_count - 1].start - old.start);
+        while (suffix < common - prefix) {
+            old_note(render, old_count - 1 - suffix, &old);
+            if (!same_note(&old, &render->notes[new_count - 1 - suffix], shift)) break;
+            suffix++;
+        }
+    }
+
+    // Before 'from' only prefix notes sound; after 'to' only suffix notes
+    // (with no shift the prefix and suffix are the same in both renders)
+    long from = LONG_MAX;
+    long to = 0;
+    long loudest_end = 0;
+    size_t new_last = shift == 0 ? new_count - suffix : new_count;
+    size_t old_last = shift == 0 ? old_count - suffix : old_count;
+    for (size_t i = prefix; i < new_last; i++) {
+        if (render->notes[i].start < from) from = (long)render->notes[i].start;
+    }
+    for (size_t i = prefix; i < old_last; i++) {
+        old_note(render, i, &old);
+        if (old.start < from) from = (long)old.start;
+    }
+    size_t first = shift == 0 ? prefix : 0;
+    for (size_t i = first; i < new_count - suffix; i++) {
+        if (render->notes[i].end > to) to = (long)render->notes[i].end;
+    }
+    for (size_t i = first; i < old_count - suffix; i++) {
+        old_note(render, i, &old);
+        if (old.end + shift > to) to = (long)(old.end + shift);
+    }
+    for (size_t i = 0; i < new_count; i++) {
+        if (render->notes[i].end > loudest_end) loudest_end = (long)render->notes[i].end;
+    }
+
+    // The old render was cut at its own length; whatever the new one
+    // keeps past that point has to be synthesized
+    if (from > render->old_total) from = render->old_total;
+    if (loudest_end > render->old_total + shift) to = render->total_samples;
+
+    if (from > render->total_samples) from = render->total_samples;
+    if (to > render->total_samples) to = render->total_samples;
+    if (to < from) to = from;
+    render->render_from = from;
+    render->render_to = to;
+    render->shift = shift;
+}
+
+/**
+ * @brief Stops saving the new cache
+ */
+static void drop_writer(IncrementalRender* render) {
+    pcm_writer_close(render->writer);
+    render->writer = NULL;
+    unlink(render->temp_path);
+}
+
+int incremental_open(IncrementalRender* render, const char* cache_path,
+                     const NoteList* list, const SynthStream* stream) {
+    memset(render, 0, sizeof(IncrementalRender));
+    if (snprintf(render->path, sizeof(render->path), "%s", cache_path) >=
+            (int)sizeof(render->path) ||
+        snprintf(render->temp_path, sizeof(render->temp_path), "%s.tmp", cache_path) >=
+            (int)sizeof(render->temp_path)) {
+        fprintf(stderr, "Error: Cache path too long\n");
+        return -1;
+    }
+
+    render->note_count = list->size;
+    render->total_samples = stream->total_samples;
+    render->notes = (CachedNote*)malloc((list->size ? list->size : 1) * sizeof(CachedNote));
+    if (!render->notes) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return -1;
+    }
+    for (size_t i = 0; i < list->size; i++) {
+        NoteEvent note;
+        Voice voice;
+        note_list_get(list, i, &note);
+        voice_init(&voice, &note, stream->sample_rate, stream->phase);
+        if (stream->draft) voice_use_draft_oscillator(&voice);
+        render->notes[i].start = voice.start;
+        render->notes[i].end = voice.start + voice.length;
+        render->notes[i].hash = voice_hash(&voice);
+    }
+
+    size_t old_count = load_previous(render, stream);
+    plan_span(render, old_count);
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.version = CACHE_VERSION;
+    header.sample_rate = stream->sample_rate;
+    header.phase = (int32_t)stream->phase;
+    header.draft = stream->draft;
+    header.total_samples = render->total_samples;
+    header.note_count = (int64_t)render->note_count;
+    render->writer = pcm_writer_open(render->temp_path, PCM_FLOAT32, false,
+                                     &header, sizeof(header));
+    if (!render->writer) fprintf(stderr, "Warning: Render cache '%s' not saved\n", render->path);
+    return 0;
+}
+
+/**
+ * @brief Copies old samples [old_from, old_from + count), zero outside the old render
+ */
+static void copy_old(const IncrementalRender* render, float* out, long old_from, long count) {
+    long begin = old_from < 0 ? 0 : old_from;
+    long end = old_from + count < render->old_total ? old_from + count : render->old_total;
+
+    for (long i = 0; i < count; i++) out[i] = 0.0f;
+    if (begin < end) {
+        memcpy(out + (begin - old_from), render->old_samples + begin,
+               (size_t)(end - begin) * sizeof(float));
+    }
+}
+
+long incremental_read(IncrementalRender* render, SynthStream* stream, float* out, long frames) {
+    long from = render->position;
+    long to = from + frames < render->total_samples ? from + frames : render->total_samples;
+    if (to <= from) return 0;
+
+    for (long t = from; t < to; ) {
+        long end;
+        if (t < render->render_from) {
+            end = to < render->render_from ? to : render->render_from;
+            copy_old(render, out + (t - from), t, end - t);
+        } else if (t < render->render_to) {
+            end = to < render->render_to ? to : render->render_to;
+            if (stream->position != t && synth_stream_seek(stream, t) != 0) return -1;
+            if (synth_stream_read(stream, out + (t - from), end - t) != end - t) return -1;
+        } else {
+            end = to;
+            copy_old(render, out + (t - from), t - render->shift, end - t);
+        }
+        t = end;
+    }
+
+    if (render->writer && pcm_writer_write(render->writer, out, to - from) != 0) {
+        fprintf(stderr, "Warning: Render cache '%s' not saved\n", render->path);
+        drop_writer(render);
+    }
+    render->position = to;
+    return to - from;
+}
+
+int incremental_close(IncrementalRender* render, bool complete) {
+    int status = 0;
+
+    if (render->previous.data) source_close(&render->previous);
+    if (render->writer && !complete) {
+        drop_writer(render);
+    } else if (render->writer) {
+        // The notes go last: their count is only known once parsing is done,
+        // but the samples are streamed as they are produced
+        if (pcm_writer_append(render->writer, render->notes,
+                              render->note_count * sizeof(CachedNote)) != 0) {
+            status = -1;
+        }
+        if (pcm_writer_close(render->writer) != 0) status = -1;
+        render->writer = NULL;
+        if (status == 0 && rename(render->temp_path, render->path) != 0) status = -1;
+        if (status != 0) {
+            fprintf(stderr, "Warning: Render cache '%s' not saved\n", render->path);
+            unlink(render->temp_path);
+        }
+    }
+
+    free(render->notes);
+    render->notes = NULL;
+    return status;
+}
@@ -0,0 +1,285 @@
+/**
+ * @file output_cache.c
+ * @brief Content-addressed on-disk cache of encoded outputs
+ * @author joaomrpimentel
+ * @version 1.1
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "output_cache.h"
+#include "note_list.h"
+#include "audio_writer.h"
+#include "sha256.h"
+
+/** Hex digits of an entry name before its extension */
+#define KEY_DIGITS (2 * SHA256_DIGEST_SIZE)
+
+/** Hex digits of entries named by revision 1 keys, still evicted */
+#define OLD_KEY_DIGITS 32
+
+/** Prefix of entries being written */
+#define TEMP_PREFIX ".tmp-"
+
+/** Temporary files older than this were left by a crashed process */
+#define TEMP_MAX_AGE_SECONDS 3600
+
+/** Bytes moved per read/write when copying */
+#define COPY_BUFFER_SIZE 65536
+
+static void key_add(Sha256* sha, const void* data, size_t size) {
+    sha256_update(sha, data, size);
+}
+
+static void key_add_int(Sha256* sha, long value) {
+    int64_t fixed = value;
+    key_add(sha, &fixed, sizeof(fixed));
+}
+
+/** Strings keep their terminator, so consecutive ones cannot run together */
+static void key_add_string(Sha256* sha, const char* text) {
+    key_add(sha, text, strlen(text) + 1);
+}
+
+void output_cache_key(OutputCacheKey* key, const NoteList* list, const CliConfig* config,
+                      OutputFormat format) {
+    Sha256 sha;
+    sha256_init(&sha);
+    key_add_int(&sha, OUTPUT_CACHE_REVISION);
+    key_add_string(&sha, CLI_VERSION);
+    key_add_string(&sha, audio_format_encoder_version(format));
+
+    // Bit depth and dither only reach the bytes of integer WAV and RAW
+    bool pcm = format == FORMAT_WAV || format == FORMAT_RAW;
+    long range_to = config->range_to >= 0.0
+                  ? (long)(config->range_to * config->sample_rate) : -1;
+    key_add_int(&sha, config->sample_rate);
+    key_add_int(&sha, config->phase);
+    key_add_int(&sha, config->preview);
+    key_add_int(&sha, config->loop_clips);
+    key_add_int(&sha, (long)(config->range_from * config->sample_rate));
+    key_add_int(&sha, range_to);
+    key_add_int(&sha, format);
+    key_add_int(&sha, pcm ? (long)config->pcm_format : -1);
+    key_add_int(&sha, pcm && config->pcm_format != PCM_FLOAT32 && config->dither);
+
+    key_add_int(&sha, (long)list->size);
+    for (size_t i = 0; i < list->size; i++) {
+        NoteEvent note;
+        note_list_get(list, i, &note);
+        key_add(&sha, &note.freq, sizeof(note.freq));
+        key_add(&sha, &note.duration, sizeof(note.duration));
+        key_add(&sha, &note.start_time, sizeof(note.start_time));
+        key_add_int(&sha, note.state.wave);
+        key_add(&sha, &note.state.envelope.attack, sizeof(float));
+        key_add(&sha, &note.state.envelope.decay, sizeof(float));
+        key_add(&sha, &note.state.envelope.sustain, sizeof(float));
+        key_add(&sha, &note.state.envelope.release, sizeof(float));
+        key_add(&sha, &note.state.slide, sizeof(note.state.slide));
+        key_add(&sha, &note.state.last_freq, sizeof(note.state.last_freq));
+    }
+    sha256_final(&sha, key->digest);
+}
+
+/**
+ * @brief Builds the path of an entry: DIR/<64 hex digits>.<extension>
+ * @return 0 on success, -1 if it does not fit
+ */
+static int entry_path(char* path, size_t size, const char* dir, const OutputCacheKey* key,
+                      OutputFormat format) {
+    char name[KEY_DIGITS + 1];
+    for (int i = 0; i < SHA256_DIGEST_SIZE; i++) {
+        snprintf(name + 2 * i, 3, "%02x", key->digest[i]);
+    }
+    int length = snprintf(path, size, "%s/%s.%s", dir, name, audio_format_extension(format));
+    return length >= 0 && (size_t)length < size ? 0 : -1;
+}
+
+/**
+ * @brief Copies the rest of one open file into another
+ * @return 0 on success, -1 on a read or write error
+ */
+static int copy_file(int from, int to) {
+    char buffer[COPY_BUFFER_SIZE];
+    for (;;) {
+        ssize_t got = read(from, buffer, sizeof(buffer));
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0) return -1;
+        if (got == 0) return 0;
+        for (ssize_t done = 0; done < got; ) {
+            ssize_t put = write(to, buffer + done, (size_t)(got - done));
+            if (put < 0 && errno == EINTR) continue;
+            if (put < 0) return -1;
+            done += put;
+        }
+    }
+}
+
+int output_cache_fetch(const char* dir, const OutputCacheKey* key, OutputFormat format,
+                       const char* output) {
+    char path[4096];
+    if (entry_path(path, sizeof(path), dir, key, format) != 0) return 0;
+
+    // An entry deleted by another process after this open stays readable
+    int entry = open(path, O_RDONLY);
+    if (entry < 0) return 0;
+
+    int fd = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Cannot write to file '%s'\n", output);
+        close(entry);
+        return -1;
+    }
+    int status = copy_file(entry, fd);
+    if (close(fd) != 0) status = -1;
+    if (status != 0) {
+        fprintf(stderr, "Error: Cannot write to file '%s'\n", output);
+        close(entry);
+        return -1;
+    }
+
+    // The modification time is the entry's last use; atime is often not kept
+    futimens(entry, NULL);
+    close(entry);
+    return 1;
+}
+
+/**
+ * @brief Entry considered for eviction
+ */
+typedef struct {
+    struct timespec used;   /**< Last store or hit */
+    off_t size;
+    char name[KEY_DIGITS + 8];
+} CacheEntry;
+
+static int compare_entries(const void* a, const void* b) {
+    const CacheEntry* x = (const CacheEntry*)a;
+    const CacheEntry* y = (const CacheEntry*)b;
+    if (x->used.tv_sec != y->used.tv_sec) return x->used.tv_sec < y->used.tv_sec ? -1 : 1;
+    if (x->used.tv_nsec != y->used.tv_nsec) return x->used.tv_nsec < y->used.tv_nsec ? -1 : 1;
+    return strcmp(x->name, y->name);
+}
+
+/**
+ * @brief Tells whether a directory entry is a cache entry
+ */
+static bool is_entry_name(const char* name) {
+    size_t length = strlen(name);
+    size_t digits = strspn(name, "0123456789abcdef");
+    if (digits != KEY_DIGITS && digits != OLD_KEY_DIGITS) return false;
+    return name[digits] == '.' && length > digits + 1 && length < KEY_DIGITS + 8;
+}
+
+/**
+ * @brief Deletes least recently used entries until the cache fits
+ * @param dir Cache directory
+ * @param max_bytes Size limit
+ *
+ * Other processes may add, touch or delete entries meanwhile; a file
+ * that is already gone is simply skipped, so the worst outcome of a race
+ * is evicting slightly more than needed.
+ */
+static void evict(const char* dir, size_t max_bytes) {
+    DIR* handle = opendir(dir);
+    if (!handle) return;
+
+    CacheEntry* entries = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    unsigned long long total = 0;
+    time_t now = time(NULL);
+    char path[4096];
+    struct dirent* item;
+
+    while ((item = readdir(handle)) != NULL) {
+        struct stat st;
+        bool entry = is_entry_name(item->d_name);
+        bool temp = strncmp(item->d_name, TEMP_PREFIX, strlen(TEMP_PREFIX)) == 0;
+        if (!entry && !temp) continue;
+        if (snprintf(path, sizeof(path), "%s/%s", dir, item->d_name) >= (int)sizeof(path) ||
+            stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        if (temp) {
+            if (now - st.st_mtime > TEMP_MAX_AGE_SECONDS) unlink(path);
+            continue;
+        }
+
+        if (count == capacity) {
+            size_t grown = capacity ? capacity * 2 : 64;
+            CacheEntry* resized = (CacheEntry*)realloc(entries, grown * sizeof(CacheEntry));
+            if (!resized) break;
+            entries = resized;
+            capacity = grown;
+        }
+        entries[count].used = st.st_mtim;
+        entries[count].size = st.st_size;
+        strcpy(entries[count].name, item->d_name);
+        total += (unsigned long long)st.st_size;
+        count++;
+    }
+    closedir(handle);
+
+    if (total > max_bytes) {
+        qsort(entries, count, sizeof(CacheEntry), compare_entries);
+        for (size_t i = 0; i < count && total > max_bytes; i++) {
+            snprintf(path, sizeof(path), "%s/%s", dir, entries[i].name);
+            unlink(path);
+            total -= (unsigned long long)entries[i].size;
+        }
+    }
+    free(entries);
+}
+
+int output_cache_store(const char* dir, size_t max_bytes, const OutputCacheKey* key,
+                       OutputFormat format, const char* output) {
+    char path[4096];
+    char temp_path[4096];
+    if (entry_path(path, sizeof(path), dir, key, format) != 0 ||
+        snprintf(temp_path, sizeof(temp_path), "%s/" TEMP_PREFIX "XXXXXX", dir) >=
+            (int)sizeof(temp_path)) {
+        fprintf(stderr, "Warning: Output cache path too long\n");
+        return -1;
+    }
+    if (mkdir(dir, 0777) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Warning: Cannot create cache directory '%s'\n", dir);
+        return -1;
+    }
+
+    // Outputs that are not regular files (a pipe, a device) cannot be read back
+    struct stat st;
+    int source = open(output, O_RDONLY);
+    if (source >= 0 && (fstat(source, &st) != 0 || !S_ISREG(st.st_mode))) {
+        close(source);
+        return 0;
+    }
+    int fd = source >= 0 ? mkstemp(temp_path) : -1;
+    if (fd < 0) {
+        fprintf(stderr, "Warning: '%s' not added to the output cache\n", output);
+        if (source >= 0) close(source);
+        return -1;
+    }
+
+    // mkstemp creates owner-only files; entries may be shared between users
+    int status = fchmod(fd, 0644);
+    if (status == 0) status = copy_file(source, fd);
+    if (close(fd) != 0) status = -1;
+    close(source);
+    if (status == 0 && rename(temp_path, path) != 0) status = -1;
+    if (status != 0) {
+        fprintf(stderr, "Warning: '%s' not added to the output cache\n", output);
+        unlink(temp_path);
+        return -1;
+    }
+
+    evict(dir, max_bytes);
+    return 0;
+}
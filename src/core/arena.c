@@ -0,0 +1,162 @@
+/**
+ * @file arena.c
+ * @brief Bump allocator for compilation-lifetime data
+ * @author joaomrpimentel
+ * @version 1.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+/** Alignment of every allocation */
+#define ARENA_ALIGN 16
+
+/** Chunk header size, rounded so chunk data starts aligned */
+#define ARENA_HEADER ((sizeof(ArenaChunk) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+static unsigned char* chunk_data(ArenaChunk* chunk) {
+    return (unsigned char*)chunk + ARENA_HEADER;
+}
+
+static size_t align_up(size_t n) {
+    return (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+/**
+ * @brief Makes arena->current able to hold 'size' more bytes
+ * @return 0 on success, -1 on allocation failure
+ *
+ * Chunks after the current one are left over from before a reset: their
+ * 'used' field is cleared when they are entered, which keeps the reset
+ * itself O(1).
+ */
+static int reserve(Arena* arena, size_t size) {
+    ArenaChunk* current = arena->current;
+    if (current && align_up(current->used) + size <= current->capacity) return 0;
+
+    ArenaChunk* next = current ? current->next : arena->head;
+    if (next && size <= next->capacity) {
+        next->used = 0;
+        arena->current = next;
+        return 0;
+    }
+
+    size_t capacity = size > arena->chunk_size ? size : arena->chunk_size;
+    ArenaChunk* chunk = (ArenaChunk*)malloc(ARENA_HEADER + capacity);
+    if (!chunk) return -1;
+
+    // Spare chunks that are too small stay behind the new one
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    chunk->next = next;
+    if (current) current->next = chunk;
+    else arena->head = chunk;
+    arena->current = chunk;
+    return 0;
+}
+
+/**
+ * @brief Gives a large allocation a block of its own
+ */
+static void* alloc_large(Arena* arena, size_t size) {
+    ArenaChunk* chunk = (ArenaChunk*)malloc(ARENA_HEADER + size);
+    if (!chunk) return NULL;
+
+    chunk->capacity = size;
+    chunk->used = size;
+    chunk->next = arena->large;
+    arena->large = chunk;
+    return chunk_data(chunk);
+}
+
+/**
+ * @brief Finds the link pointing at the large block holding ptr
+ * @return Link to update, or NULL if ptr is not a large allocation
+ */
+static ArenaChunk** find_large(Arena* arena, void* ptr) {
+    for (ArenaChunk** link = &arena->large; *link; link = &(*link)->next) {
+        if (chunk_data(*link) == ptr) return link;
+    }
+    return NULL;
+}
+
+static void free_chunks(ArenaChunk* chunk) {
+    while (chunk) {
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+}
+
+void arena_init(Arena* arena, size_t chunk_size) {
+    arena->head = NULL;
+    arena->current = NULL;
+    arena->large = NULL;
+    arena->last = NULL;
+    arena->chunk_size = chunk_size ? chunk_size : ARENA_CHUNK_SIZE;
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    if (!arena) return malloc(size);
+    if (size == 0) size = 1;
+    if (size > arena->chunk_size / 4) return alloc_large(arena, size);
+
+    if (reserve(arena, size) != 0) return NULL;
+
+    ArenaChunk* chunk = arena->current;
+    size_t offset = align_up(chunk->used);
+    chunk->used = offset + size;
+    arena->last = chunk_data(chunk) + offset;
+    return arena->last;
+}
+
+void* arena_realloc(Arena* arena, void* ptr, size_t old_size, size_t new_size) {
+    if (!arena) return realloc(ptr, new_size);
+    if (!ptr) return arena_alloc(arena, new_size);
+
+    ArenaChunk** link = old_size > arena->chunk_size / 4 ? find_large(arena, ptr) : NULL;
+    if (link) {
+        ArenaChunk* grown = (ArenaChunk*)realloc(*link, ARENA_HEADER + new_size);
+        if (!grown) return NULL;
+        grown->capacity = new_size;
+        grown->used = new_size;
+        *link = grown;
+        return chunk_data(grown);
+    }
+
+    ArenaChunk* chunk = arena->current;
+    if (ptr == arena->last) {
+        size_t offset = (size_t)((unsigned char*)ptr - chunk_data(chunk));
+        if (offset + new_size <= chunk->capacity) {
+            chunk->used = offset + new_size;
+            return ptr;
+        }
+    }
+
+    void* moved = arena_alloc(arena, new_size);
+    if (!moved) return NULL;
+    memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+    return moved;
+}
+
+void arena_release(Arena* arena, void* ptr) {
+    if (!arena) free(ptr);
+}
+
+void arena_reset(Arena* arena) {
+    free_chunks(arena->large);
+    arena->large = NULL;
+    arena->current = arena->head;
+    arena->last = NULL;
+    if (arena->head) arena->head->used = 0;
+}
+
+void arena_free(Arena* arena) {
+    free_chunks(arena->head);
+    free_chunks(arena->large);
+    arena->head = NULL;
+    arena->current = NULL;
+    arena->large = NULL;
+    arena->last = NULL;
+}
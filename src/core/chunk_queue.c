@@ -0,0 +1,157 @@
+/**
+ * @file chunk_queue.c
+ * @brief Bounded single-producer/multi-consumer queue of audio chunks
+ * @author joaomrpimentel
+ * @version 1.1
+ */
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "chunk_queue.h"
+
+/**
+ * Chunks form a ring indexed by sequence number modulo depth. The
+ * producer has pushed `pushed` chunks; each consumer has popped
+ * `popped[c]` and released `released[c]` of them. The next chunk to fill
+ * is free once every attached consumer released the chunk that last
+ * used its slot, i.e. pushed - min(released) < depth.
+ */
+struct ChunkQueue {
+    Chunk* chunks;
+    int depth;
+    int consumers;
+    size_t pushed;
+    size_t popped[CHUNK_QUEUE_MAX_CONSUMERS];
+    size_t released[CHUNK_QUEUE_MAX_CONSUMERS];
+    bool detached[CHUNK_QUEUE_MAX_CONSUMERS];
+    int attached;               /**< Consumers not detached */
+    bool closed;
+    bool aborted;
+    pthread_mutex_t lock;
+    pthread_cond_t not_full;    /**< Signaled when a chunk is released or a consumer detaches */
+    pthread_cond_t not_empty;   /**< Signaled on push, close and abort */
+};
+
+ChunkQueue* chunk_queue_create(int depth, long chunk_frames, int consumers, bool with_pcm24) {
+    if (depth < 1) depth = 1;
+    if (consumers < 1 || consumers > CHUNK_QUEUE_MAX_CONSUMERS) return NULL;
+
+    ChunkQueue* queue = (ChunkQueue*)calloc(1, sizeof(ChunkQueue));
+    if (!queue) return NULL;
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->not_full, NULL);
+    pthread_cond_init(&queue->not_empty, NULL);
+    queue->consumers = consumers;
+    queue->attached = consumers;
+
+    queue->chunks = (Chunk*)calloc(depth, sizeof(Chunk));
+    if (!queue->chunks) {
+        chunk_queue_destroy(queue);
+        return NULL;
+    }
+    queue->depth = depth;
+    for (int i = 0; i < depth; i++) {
+        Chunk* chunk = &queue->chunks[i];
+        chunk->samples = (float*)malloc(chunk_frames * sizeof(float));
+        if (with_pcm24) chunk->pcm24 = (int32_t*)malloc(chunk_frames * sizeof(int32_t));
+        if (!chunk->samples || (with_pcm24 && !chunk->pcm24)) {
+            chunk_queue_destroy(queue);
+            return NULL;
+        }
+    }
+    return queue;
+}
+
+/**
+ * @brief Tells whether the next slot is still held by a consumer (lock held)
+ */
+static bool queue_full(const ChunkQueue* queue) {
+    for (int c = 0; c < queue->consumers; c++) {
+        if (!queue->detached[c] && queue->pushed - queue->released[c] >= (size_t)queue->depth) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Chunk* chunk_queue_acquire(ChunkQueue* queue) {
+    pthread_mutex_lock(&queue->lock);
+    while (!queue->aborted && queue->attached > 0 && queue_full(queue)) {
+        pthread_cond_wait(&queue->not_full, &queue->lock);
+    }
+    Chunk* chunk = NULL;
+    if (!queue->aborted && queue->attached > 0) {
+        chunk = &queue->chunks[queue->pushed % queue->depth];
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return chunk;
+}
+
+void chunk_queue_push(ChunkQueue* queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->pushed++;
+    pthread_cond_broadcast(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+void chunk_queue_close(ChunkQueue* queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->closed = true;
+    pthread_cond_broadcast(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+const Chunk* chunk_queue_pop(ChunkQueue* queue, int consumer) {
+    pthread_mutex_lock(&queue->lock);
+    while (queue->popped[consumer] == queue->pushed && !queue->closed && !queue->aborted) {
+        pthread_cond_wait(&queue->not_empty, &queue->lock);
+    }
+    const Chunk* chunk = NULL;
+    if (queue->popped[consumer] < queue->pushed && !queue->aborted) {
+        chunk = &queue->chunks[queue->popped[consumer] % queue->depth];
+        queue->popped[consumer]++;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return chunk;
+}
+
+void chunk_queue_release(ChunkQueue* queue, int consumer) {
+    pthread_mutex_lock(&queue->lock);
+    queue->released[consumer]++;
+    pthread_cond_signal(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+void chunk_queue_detach(ChunkQueue* queue, int consumer) {
+    pthread_mutex_lock(&queue->lock);
+    if (!queue->detached[consumer]) {
+        queue->detached[consumer] = true;
+        queue->attached--;
+        pthread_cond_signal(&queue->not_full);
+    }
+    pthread_mutex_unlock(&queue->lock);
+}
+
+void chunk_queue_abort(ChunkQueue* queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->aborted = true;
+    pthread_cond_broadcast(&queue->not_full);
+    pthread_cond_broadcast(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+void chunk_queue_destroy(ChunkQueue* queue) {
+    if (!queue) return;
+
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->not_full);
+    pthread_cond_destroy(&queue->not_empty);
+    if (queue->chunks) {
+        for (int i = 0; i < queue->depth; i++) {
+            free(queue->chunks[i].samples);
+            free(queue->chunks[i].pcm24);
+        }
+    }
+    free(queue->chunks);
+    free(queue);
+}
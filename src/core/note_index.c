@@ -0,0 +1,149 @@
+/**
+ * @file note_index.c
+ * @brief Interval index answering "which notes sound in [from, to)"
+ * @author joaomrpimentel
+ * @version 1.0
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include "note_index.h"
+
+/** Subtrees of this level or lower are scanned instead of descended */
+#define INDEX_SCAN_LEVEL 3
+
+static int compare_intervals(const void* a, const void* b) {
+    const NoteInterval* x = (const NoteInterval*)a;
+    const NoteInterval* y = (const NoteInterval*)b;
+    if (x->start != y->start) return (x->start > y->start) - (x->start < y->start);
+    return (x->note > y->note) - (x->note < y->note);
+}
+
+/**
+ * @brief Fills max_end bottom-up, level by level
+ * @param index Index with sorted intervals
+ * @return Level of the root
+ *
+ * Nodes past the end of the array are not stored; a right child that
+ * falls there is replaced by the largest end of the last real subtree
+ * at that level ('last').
+ */
+static int compute_max_ends(NoteIndex* index) {
+    NoteInterval* items = index->items;
+    size_t n = index->count;
+    size_t last_i = 0;
+    long last = 0;
+    int k;
+
+    for (size_t i = 0; i < n; i += 2) {
+        last_i = i;
+        last = items[i].max_end = items[i].end;
+    }
+    for (k = 1; ((size_t)1 << k) <= n; k++) {
+        size_t x = (size_t)1 << (k - 1);
+        size_t step = x << 2;
+        for (size_t i = (x << 1) - 1; i < n; i += step) {
+            long left = items[i - x].max_end;
+            long right = i + x < n ? items[i + x].max_end : last;
+            long end = items[i].end;
+            if (left > end) end = left;
+            if (right > end) end = right;
+            items[i].max_end = end;
+        }
+        last_i = (last_i >> k & 1) ? last_i - x : last_i + x;
+        if (last_i < n && items[last_i].max_end > last) last = items[last_i].max_end;
+    }
+    return k - 1;
+}
+
+int note_index_build(NoteIndex* index, const long* starts, const long* ends, size_t count) {
+    index->count = count;
+    index->levels = 0;
+    index->items = (NoteInterval*)malloc((count ? count : 1) * sizeof(NoteInterval));
+    if (!index->items) return -1;
+
+    bool sorted = true;
+    for (size_t i = 0; i < count; i++) {
+        index->items[i].start = starts[i];
+        index->items[i].end = ends[i];
+        index->items[i].note = i;
+        if (i > 0 && starts[i] < starts[i - 1]) sorted = false;
+    }
+    if (!sorted) qsort(index->items, count, sizeof(NoteInterval), compare_intervals);
+
+    if (count > 0) index->levels = compute_max_ends(index);
+    return 0;
+}
+
+size_t note_index_query(const NoteIndex* index, long from, long to,
+                        NoteIndexVisit visit, void* context) {
+    struct { size_t x; int k; bool left_done; } stack[64];
+    const NoteInterval* items = index->items;
+    size_t n = index->count;
+    size_t hits = 0;
+    int top = 0;
+    if (n == 0) return 0;
+
+    // In-order walk, so hits come out sorted by position
+    stack[top].x = ((size_t)1 << index->levels) - 1;
+    stack[top].k = index->levels;
+    stack[top++].left_done = false;
+    while (top > 0) {
+        size_t x = stack[--top].x;
+        int k = stack[top].k;
+        bool left_done = stack[top].left_done;
+
+        if (k <= INDEX_SCAN_LEVEL) {
+            size_t first = x >> k << k;
+            size_t last = first + ((size_t)1 << (k + 1)) - 1;
+            if (last > n) last = n;
+            for (size_t i = first; i < last && items[i].start < to; i++) {
+                if (items[i].end > from) {
+                    visit(items[i].note, context);
+                    hits++;
+                }
+            }
+        } else if (!left_done) {
+            // Revisit this node after its left subtree; a left child past
+            // the array has no stored bound and is always descended
+            size_t left = x - ((size_t)1 << (k - 1));
+            stack[top].x = x;
+            stack[top].k = k;
+            stack[top++].left_done = true;
+            if (left >= n || items[left].max_end > from) {
+                stack[top].x = left;
+                stack[top].k = k - 1;
+                stack[top++].left_done = false;
+            }
+        } else if (x < n && items[x].start < to) {
+            if (items[x].end > from) {
+                visit(items[x].note, context);
+                hits++;
+            }
+            size_t right = x + ((size_t)1 << (k - 1));
+            if (right >= n || items[right].max_end > from) {
+                stack[top].x = right;
+                stack[top].k = k - 1;
+                stack[top++].left_done = false;
+            }
+        }
+    }
+    return hits;
+}
+
+size_t note_index_starts_before(const NoteIndex* index, long sample) {
+    size_t lo = 0;
+    size_t hi = index->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index->items[mid].start < sample) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+void note_index_free(NoteIndex* index) {
+    free(index->items);
+    index->items = NULL;
+    index->count = 0;
+}
@@ -2,37 +2,231 @@
  * @file note_list.c
  * @brief Dynamic note list data structure implementation
  * @author joaomrpimentel
- * @version 1.0
+ * @version 1.4
  */
 
-#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
 #include "note_list.h"
+#include "hash.h"
+#include "arena.h"
 
-void note_list_init(NoteList* list) {
-    list->capacity = 16;
+/** Initial note capacity */
+#define NOTE_LIST_CAPACITY 16
+
+/** Initial state table capacity (hash slots are twice as many) */
+#define NOTE_STATE_CAPACITY 16
+
+/**
+ * @brief Grows one column
+ * @return 0 on success, -1 on allocation failure (the column is kept)
+ */
+static int grow_column(NoteList* list, void** column, size_t old_capacity,
+                       size_t capacity, size_t element_size) {
+    void* grown = arena_realloc(list->arena, *column, old_capacity * element_size,
+                                capacity * element_size);
+    if (!grown) return -1;
+    *column = grown;
+    return 0;
+}
+
+/**
+ * @brief Hashes every field of a synthesizer state
+ */
+static uint64_t hash_state(const SynthState* state) {
+    uint64_t h = HASH_SEED;
+    h = hash_bytes(h, &state->wave, sizeof(state->wave));
+    h = hash_bytes(h, &state->envelope.attack, sizeof(float));
+    h = hash_bytes(h, &state->envelope.decay, sizeof(float));
+    h = hash_bytes(h, &state->envelope.sustain, sizeof(float));
+    h = hash_bytes(h, &state->envelope.release, sizeof(float));
+    h = hash_bytes(h, &state->slide, sizeof(float));
+    h = hash_bytes(h, &state->last_freq, sizeof(float));
+    return h;
+}
+
+/**
+ * @brief Compares states bit by bit, so -0.0 and NaN values round-trip
+ */
+static bool states_equal(const SynthState* a, const SynthState* b) {
+    return a->wave == b->wave &&
+           memcmp(&a->envelope.attack, &b->envelope.attack, sizeof(float)) == 0 &&
+           memcmp(&a->envelope.decay, &b->envelope.decay, sizeof(float)) == 0 &&
+           memcmp(&a->envelope.sustain, &b->envelope.sustain, sizeof(float)) == 0 &&
+           memcmp(&a->envelope.release, &b->envelope.release, sizeof(float)) == 0 &&
+           memcmp(&a->slide, &b->slide, sizeof(float)) == 0 &&
+           memcmp(&a->last_freq, &b->last_freq, sizeof(float)) == 0;
+}
+
+/**
+ * @brief Replaces the hash slots with a table of slot_count entries
+ * @return 0 on success, -1 on allocation failure (the old table is kept)
+ */
+static int rehash_states(NoteList* list, size_t slot_count) {
+    uint32_t* slots = (uint32_t*)arena_alloc(list->arena, slot_count * sizeof(uint32_t));
+    if (!slots) return -1;
+    memset(slots, 0, slot_count * sizeof(uint32_t));
+
+    for (size_t i = 0; i < list->state_count; i++) {
+        size_t slot = hash_state(&list->states[i]) & (slot_count - 1);
+        while (slots[slot]) slot = (slot + 1) & (slot_count - 1);
+        slots[slot] = (uint32_t)(i + 1);
+    }
+
+    arena_release(list->arena, list->state_slots);
+    list->state_slots = slots;
+    list->slot_count = slot_count;
+    return 0;
+}
+
+/**
+ * @brief Finds the index of a state, adding it to the table if new
+ * @param list Target list
+ * @param state State to intern
+ * @param index Output state index
+ * @return 0 on success, -1 on allocation failure or a full table
+ */
+static int intern_state(NoteList* list, const SynthState* state, uint32_t* index) {
+    size_t slot = hash_state(state) & (list->slot_count - 1);
+    while (list->state_slots[slot]) {
+        size_t found = list->state_slots[slot] - 1;
+        if (states_equal(&list->states[found], state)) {
+            *index = (uint32_t)found;
+            return 0;
+        }
+        slot = (slot + 1) & (list->slot_count - 1);
+    }
+
+    if (list->state_count >= NOTE_STATE_MAX) return -1;
+
+    if (list->state_count >= list->state_capacity) {
+        size_t capacity = list->state_capacity * 2;
+        if (grow_column(list, (void**)&list->states, list->state_capacity,
+                        capacity, sizeof(SynthState)) != 0) {
+            return -1;
+        }
+        list->state_capacity = capacity;
+        if (rehash_states(list, capacity * 2) != 0) return -1;
+        return intern_state(list, state, index);
+    }
+
+    list->states[list->state_count] = *state;
+    list->state_slots[slot] = (uint32_t)(list->state_count + 1);
+    *index = (uint32_t)list->state_count++;
+    return 0;
+}
+
+int note_list_init_arena(NoteList* list, Arena* arena) {
+    list->arena = arena;
+    list->capacity = NOTE_LIST_CAPACITY;
     list->size = 0;
-    list->notes = (NoteEvent*)malloc(list->capacity * sizeof(NoteEvent));
-    if (!list->notes) {
-        fprintf(stderr, "Error: Memory allocation failed\n");
-        exit(1);
+    list->freq = (float*)arena_alloc(arena, list->capacity * sizeof(float));
+    list->duration = (float*)arena_alloc(arena, list->capacity * sizeof(float));
+    list->start_time = (float*)arena_alloc(arena, list->capacity * sizeof(float));
+    list->state = (uint32_t*)arena_alloc(arena, list->capacity * sizeof(uint32_t));
+
+    list->state_capacity = NOTE_STATE_CAPACITY;
+    list->state_count = 0;
+    list->states = (SynthState*)arena_alloc(arena, list->state_capacity * sizeof(SynthState));
+    list->state_slots = NULL;
+    list->slot_count = 0;
+
+    if (!list->freq || !list->duration || !list->start_time || !list->state ||
+        !list->states || rehash_states(list, list->state_capacity * 2) != 0) {
+        note_list_free(list);
+        return -1;
     }
+    return 0;
 }
 
-void note_list_add(NoteList* list, NoteEvent note) {
+int note_list_push(NoteList* list, NoteEvent note) {
     if (list->size >= list->capacity) {
-        list->capacity *= 2;
-        list->notes = (NoteEvent*)realloc(list->notes, list->capacity * sizeof(NoteEvent));
-        if (!list->notes) {
-            fprintf(stderr, "Error: Memory reallocation failed\n");
-            exit(1);
+        size_t capacity = list->capacity * 2;
+        if (grow_column(list, (void**)&list->freq, list->capacity, capacity, sizeof(float)) != 0 ||
+            grow_column(list, (void**)&list->duration, list->capacity, capacity, sizeof(float)) != 0 ||
+            grow_column(list, (void**)&list->start_time, list->capacity, capacity, sizeof(float)) != 0 ||
+            grow_column(list, (void**)&list->state, list->capacity, capacity, sizeof(uint32_t)) != 0) {
+            return -1;
         }
+        list->capacity = capacity;
+    }
+
+    // A slide from the previous note is the common case: store it as a flag
+    uint32_t legato = 0;
+    if (list->size > 0 && note.state.last_freq != 0.0f &&
+        memcmp(&note.state.last_freq, &list->freq[list->size - 1], sizeof(float)) == 0) {
+        note.state.last_freq = 0.0f;
+        legato = NOTE_STATE_LEGATO;
+    }
+
+    // Consecutive notes usually share a state: skip the hash when they do
+    uint32_t state;
+    if (list->size > 0 &&
+        states_equal(note_list_state(list, list->size - 1), &note.state)) {
+        state = list->state[list->size - 1] & NOTE_STATE_INDEX_MASK;
+    } else if (intern_state(list, &note.state, &state) != 0) {
+        return -1;
+    }
+
+    size_t i = list->size++;
+    list->freq[i] = note.freq;
+    list->duration[i] = note.duration;
+    list->start_time[i] = note.start_time;
+    list->state[i] = state | legato;
+    return 0;
+}
+
+void note_list_get(const NoteList* list, size_t index, NoteEvent* note) {
+    note->freq = list->freq[index];
+    note->duration = list->duration[index];
+    note->start_time = list->start_time[index];
+    note->state = *note_list_state(list, index);
+    if (list->state[index] & NOTE_STATE_LEGATO) {
+        note->state.last_freq = list->freq[index - 1];
     }
-    list->notes[list->size++] = note;
 }
 
 void note_list_free(NoteList* list) {
-    free(list->notes);
+    arena_release(list->arena, list->freq);
+    arena_release(list->arena, list->duration);
+    arena_release(list->arena, list->start_time);
+    arena_release(list->arena, list->state);
+    arena_release(list->arena, list->states);
+    arena_release(list->arena, list->state_slots);
+    list->freq = NULL;
+    list->duration = NULL;
+    list->start_time = NULL;
+    list->state = NULL;
+    list->states = NULL;
+    list->state_slots = NULL;
     list->size = 0;
     list->capacity = 0;
-}
\ No newline at end of file
+    list->state_count = 0;
+    list->state_capacity = 0;
+}
+
+void loop_list_init(LoopList* loops) {
+    loops->spans = NULL;
+    loops->size = 0;
+    loops->capacity = 0;
+}
+
+int loop_list_add(LoopList* loops, LoopSpan span) {
+    if (loops->size >= loops->capacity) {
+        size_t capacity = loops->capacity ? loops->capacity * 2 : 16;
+        LoopSpan* grown = (LoopSpan*)realloc(loops->spans, capacity * sizeof(LoopSpan));
+        if (!grown) return -1;
+        loops->spans = grown;
+        loops->capacity = capacity;
+    }
+    loops->spans[loops->size++] = span;
+    return 0;
+}
+
+void loop_list_free(LoopList* loops) {
+    free(loops->spans);
+    loops->spans = NULL;
+    loops->size = 0;
+    loops->capacity = 0;
+}
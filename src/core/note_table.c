@@ -2,107 +2,91 @@
  * @file note_table.c
  * @brief Implementation of musical note frequency lookup
  * @author joaomrpimentel
- * @version 1.1
+ * @version 1.2
  */
 
 #include <string.h>
-#include <ctype.h>
-#include <math.h>
 #include "note_table.h"
 
 /**
- * @brief Converts note name to MIDI note number
- * @param note_name Scientific pitch notation (e.g., "C4", "F#3")
- * @return MIDI note number (0-127), or -1 if invalid
- * 
- * MIDI note numbering:
- * - C-1 = 0, C0 = 12, C4 (middle C) = 60, A4 = 69, G9 = 127
- * - Each octave spans 12 semitones
+ * @brief Equal-temperament frequency of every MIDI note
+ *
+ * Values are 440 * 2^((n - 69) / 12) evaluated in single precision, the
+ * same numbers the powf formula produced before the table existed.
  */
-static int note_to_midi(const char* note_name) {
-    if (!note_name || strlen(note_name) < 2) {
-        return -1;
-    }
-    
-    // Parse note letter (C, D, E, F, G, A, B)
-    char note_letter = toupper(note_name[0]);
-    int note_offset;
-    
-    switch (note_letter) {
-        case 'C': note_offset = 0; break;
-        case 'D': note_offset = 2; break;
-        case 'E': note_offset = 4; break;
-        case 'F': note_offset = 5; break;
-        case 'G': note_offset = 7; break;
-        case 'A': note_offset = 9; break;
-        case 'B': note_offset = 11; break;
-        default: return -1;
-    }
-    
+const float note_freq_table[NOTE_MIDI_COUNT] = {
+    8.17579842f, 8.66195774f, 9.17702293f, 9.72271824f, 10.3008623f, 10.9133816f,
+    11.5623255f, 12.2498589f, 12.9782696f, 13.75f, 14.5676203f, 15.4338512f,
+    16.3515968f, 17.3239155f, 18.3540459f, 19.4454365f, 20.6017246f, 21.8267632f,
+    23.124651f, 24.4997177f, 25.9565392f, 27.5f, 29.1352329f, 30.8677101f,
+    32.7031937f, 34.6478271f, 36.7080994f, 38.890873f, 41.2034416f, 43.6535301f,
+    46.2493019f, 48.999424f, 51.9130898f, 55.0f, 58.2704659f, 61.7354202f,
+    65.4063873f, 69.2956543f, 73.4161987f, 77.7817459f, 82.4068832f, 87.3070602f,
+    92.4986038f, 97.998848f, 103.82618f, 110.0f, 116.540947f, 123.470825f,
+    130.812775f, 138.591324f, 146.832382f, 155.563492f, 164.813782f, 174.61412f,
+    184.997208f, 195.997726f, 207.652344f, 220.0f, 233.081863f, 246.94165f,
+    261.625549f, 277.182648f, 293.664764f, 311.126984f, 329.627563f, 349.228241f,
+    369.994415f, 391.995422f, 415.304688f, 440.0f, 466.163788f, 493.883301f,
+    523.251099f, 554.365295f, 587.329529f, 622.253967f, 659.255127f, 698.456482f,
+    739.988831f, 783.990845f, 830.609375f, 880.0f, 932.327576f, 987.766602f,
+    1046.5022f, 1108.73059f, 1174.65906f, 1244.50793f, 1318.51025f, 1396.91296f,
+    1479.97766f, 1567.98181f, 1661.21875f, 1760.0f, 1864.65491f, 1975.53345f,
+    2093.00439f, 2217.46094f, 2349.31836f, 2489.01587f, 2637.02026f, 2793.82593f,
+    2959.95532f, 3135.96313f, 3322.43774f, 3520.0f, 3729.30981f, 3951.06689f,
+    4186.00879f, 4434.92188f, 4698.63672f, 4978.03174f, 5274.04053f, 5587.65186f,
+    5919.91064f, 6271.92627f, 6644.87549f, 7040.0f, 7458.62158f, 7902.13184f,
+    8372.01758f, 8869.84473f, 9397.27148f, 9956.06348f, 10548.083f, 11175.3027f,
+    11839.8213f, 12543.8555f
+};
+
+/** Semitone offset of each letter from C, indexed by (letter | 0x20) - 'a' */
+static const signed char letter_offset[7] = {
+    9, 11, 0, 2, 4, 5, 7     // A B C D E F G
+};
+
+int note_name_to_midi(const char* name, size_t length) {
+    if (length < 2) return -1;
+
+    // Parse note letter (C, D, E, F, G, A, B), either case
+    unsigned letter = (unsigned)((name[0] | 0x20) - 'a');
+    if (letter >= 7) return -1;
+    int midi = letter_offset[letter];
+
     // Parse accidental (# or b)
-    int accidental = 0;
-    int octave_pos = 1;
-    
-    if (note_name[1] == '#') {
-        accidental = 1;
-        octave_pos = 2;
-    } else if (note_name[1] == 'b') {
-        accidental = -1;
-        octave_pos = 2;
-    }
-    
-    // Parse octave number (can be negative or two digits)
-    if (!isdigit(note_name[octave_pos]) && note_name[octave_pos] != '-') {
-        return -1;
+    size_t pos = 1;
+    if (name[1] == '#') {
+        midi++;
+        pos = 2;
+    } else if (name[1] == 'b') {
+        midi--;
+        pos = 2;
     }
-    
+
+    // Parse octave number: one negative digit, or up to two digits.
+    // Anything after the octave is ignored, as before.
+    if (pos >= length) return -1;
     int octave;
-    if (note_name[octave_pos] == '-') {
-        // Negative octave (e.g., "C-1")
-        if (!isdigit(note_name[octave_pos + 1])) {
-            return -1;
-        }
-        octave = -(note_name[octave_pos + 1] - '0');
+    if (name[pos] == '-') {
+        if (pos + 1 >= length || (unsigned)(name[pos + 1] - '0') > 9) return -1;
+        octave = -(name[pos + 1] - '0');
     } else {
-        octave = note_name[octave_pos] - '0';
-        
-        // Handle two-digit octave numbers (e.g., "C10")
-        if (note_name[octave_pos + 1] && isdigit(note_name[octave_pos + 1])) {
-            octave = octave * 10 + (note_name[octave_pos + 1] - '0');
+        unsigned digit = (unsigned)(name[pos] - '0');
+        if (digit > 9) return -1;
+        octave = (int)digit;
+        if (pos + 1 < length && (unsigned)(name[pos + 1] - '0') <= 9) {
+            octave = octave * 10 + (name[pos + 1] - '0');
         }
     }
-    
-    // Calculate MIDI note number
-    // MIDI: C-1 = 0, C0 = 12, C4 = 60
-    int midi_note = (octave + 1) * 12 + note_offset + accidental;
-    
-    // Validate range (MIDI: 0-127)
-    if (midi_note < 0 || midi_note > 127) {
-        return -1;
-    }
-    
-    return midi_note;
-}
 
-/**
- * @brief Converts MIDI note number to frequency
- * @param midi_note MIDI note number (0-127)
- * @return Frequency in Hz using equal temperament
- * 
- * Formula: f = 440 * 2^((n - 69) / 12)
- * Where n is MIDI note number, 69 = A4 = 440 Hz
- */
-static float midi_to_freq(int midi_note) {
-    // A4 (MIDI note 69) = 440 Hz
-    return 440.0f * powf(2.0f, (midi_note - 69) / 12.0f);
+    // MIDI: C-1 = 0, C0 = 12, C4 = 60
+    midi += (octave + 1) * 12;
+    if (midi < 0 || midi >= NOTE_MIDI_COUNT) return -1;
+    return midi;
 }
 
 float get_note_freq(const char* note_name) {
-    int midi_note = note_to_midi(note_name);
-    
-    if (midi_note < 0) {
-        return 0.0f;
-    }
-    
-    return midi_to_freq(midi_note);
-}
\ No newline at end of file
+    if (!note_name) return 0.0f;
+
+    int midi_note = note_name_to_midi(note_name, strlen(note_name));
+    return midi_note < 0 ? 0.0f : note_freq_table[midi_note];
+}
@@ -0,0 +1,85 @@
+/**
+ * @file source.c
+ * @brief Read-only access to source files, memory-mapped when possible
+ * @author joaomrpimentel
+ * @version 1.2
+ */
+
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "source.h"
+
+/** Read size for files that cannot be mapped */
+#define SOURCE_READ_CHUNK 65536
+
+/**
+ * @brief Reads a whole file descriptor into a heap buffer
+ * @return 0 on success, -1 on error
+ */
+static int read_all(Source* source, int fd) {
+    size_t capacity = SOURCE_READ_CHUNK;
+    size_t size = 0;
+    char* data = (char*)malloc(capacity);
+    if (!data) return -1;
+
+    for (;;) {
+        if (size == capacity) {
+            capacity *= 2;
+            char* grown = (char*)realloc(data, capacity);
+            if (!grown) {
+                free(data);
+                return -1;
+            }
+            data = grown;
+        }
+        ssize_t n = read(fd, data + size, capacity - size);
+        if (n < 0) {
+            free(data);
+            return -1;
+        }
+        if (n == 0) break;
+        size += (size_t)n;
+    }
+
+    source->data = data;
+    source->size = size;
+    source->mapped = false;
+    return 0;
+}
+
+int source_map(Source* source, const char* path) {
+    source->data = NULL;
+    source->size = 0;
+    source->mapped = false;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            posix_madvise(data, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+            source->data = (const char*)data;
+            source->size = (size_t)st.st_size;
+            source->mapped = true;
+            close(fd);
+            return 0;
+        }
+    }
+
+    int status = read_all(source, fd);
+    close(fd);
+    return status;
+}
+
+void source_close(Source* source) {
+    if (source->mapped) munmap((void*)source->data, source->size);
+    else free((void*)source->data);
+    source->data = NULL;
+    source->size = 0;
+    source->mapped = false;
+}
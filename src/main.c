@@ -2,82 +2,65 @@
  * @file main.c
  * @brief JSHL Compiler - Main program entry point
  * @author joaomrpimentel
- * @version 1.0
+ * @version 1.1
  * 
  * Orchestrates the compilation pipeline: file I/O, parsing, synthesis, and export.
  */
 
 #include <stdio.h>
-#include <stdlib.h>
-#include <stdint.h>
 #include "jshl_compiler.h"
-#include "note_list.h"
-#include "parser.h"
-#include "synth.h"
-#include "wav_writer.h"
+#include "cli.h"
+#include "compile_job.h"
+#include "batch.h"
 
 /**
  * @brief Main program execution
  * @param argc Argument count
- * @param argv Argument vector [program, input.jshl, output.wav]
+ * @param argv Argument vector (see cli_print_help)
  * @return 0 on success, 1 on error
  * 
- * Usage: jshl <input.jshl> [output.wav]
+ * Usage: jshl [OPTIONS] <input.jshl> [output]
+ *        jshl [OPTIONS] -d DIR <input.jshl>...
+ *        jshl [OPTIONS] -b MANIFEST [-d DIR]
  * 
  * Pipeline:
- * 1. Load JSHL source file
- * 2. Parse into note event list
- * 3. Render to audio buffer
- * 4. Export as WAV file
+ * 1. Map JSHL source file
+ * 2. Parse into note event list (recording loop spans for --loop-clips)
+ * 3. Render in fixed-size chunks (optionally on several threads)
+ * 4. Stream each chunk into the selected output format
+ *
+ * In batch mode every input runs this pipeline on a worker pool (see
+ * batch_run); the exit status is 1 if any file failed.
  */
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s <input.jshl> [output.wav]\n", argv[0]);
+    CliConfig config;
+    if (!cli_parse_args(argc, argv, &config)) {
+        if (config.show_help) {
+            cli_print_help(argv[0]);
+            return 0;
+        }
+        if (config.show_version) {
+            cli_print_version();
+            return 0;
+        }
         return 1;
     }
 
-    const char* input_file = argv[1];
-    const char* output_file = (argc > 2) ? argv[2] : "output.wav";
-
-    FILE* fp = fopen(input_file, "r");
-    if (!fp) {
-        fprintf(stderr, "Error: Cannot read file '%s'\n", input_file);
-        return 1;
+    if (cli_is_batch(&config)) {
+        return batch_run(&config) == 0 ? 0 : 1;
     }
-    fseek(fp, 0, SEEK_END);
-    long file_size = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
 
-    char* code_buffer = (char*)malloc(file_size + 1);
-    if (!code_buffer) {
-        fprintf(stderr, "Error: Memory allocation failed\n");
-        fclose(fp);
-        return 1;
+    CompileOutput outputs[CLI_MAX_OUTPUTS];
+    for (int i = 0; i < config.output_count; i++) {
+        outputs[i].file = config.output_files[i];
+        outputs[i].format = cli_output_format(&config, config.output_files[i]);
     }
-    fread(code_buffer, 1, file_size, fp);
-    code_buffer[file_size] = '\0';
-    fclose(fp);
 
-    NoteList note_list;
-    note_list_init(&note_list);
-    parse_jshl(code_buffer, &note_list);
-    
-    long total_samples = 0;
-    float* audio_buffer = render_audio(&note_list, &total_samples);
-
-    if (audio_buffer) {
-        write_wav_file(output_file, audio_buffer, total_samples);
-        printf("Compiled: %zu notes, %.2fs → %s\n", 
-               note_list.size, 
-               (float)total_samples / SAMPLE_RATE, 
-               output_file);
-        free(audio_buffer);
-    } else {
-        fprintf(stderr, "Error: No notes to render\n");
+    CompileResult result;
+    if (compile_job_run(&config, config.input_file, outputs, config.output_count,
+                        &result) != 0) {
+        return 1;
     }
 
-    free(code_buffer);
-    note_list_free(&note_list);
-
     return 0;
-}
\ No newline at end of file
+}
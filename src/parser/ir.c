@@ -0,0 +1,148 @@
+/**
+ * @file ir.c
+ * @brief Intermediate representation storage and evaluation
+ * @author joaomrpimentel
+ * @version 1.3
+ */
+
+#include <stdlib.h>
+#include "ir.h"
+#include "note_list.h"
+
+/**
+ * @brief Loop being evaluated
+ */
+typedef struct {
+    size_t body;        /**< First instruction of the loop body */
+    int remaining;      /**< Iterations left after the current one */
+    size_t first_note;  /**< Notes in the list when the loop started */
+} LoopFrame;
+
+int program_init_arena(Program* program, Arena* arena) {
+    program->arena = arena;
+    program->capacity = 64;
+    program->size = 0;
+    program->max_depth = 0;
+    program->report = NULL;
+    program->warnings = 0;
+    program->first_warning_line = 0;
+    program->code = (Instruction*)arena_alloc(arena, program->capacity * sizeof(Instruction));
+    return program->code ? 0 : -1;
+}
+
+size_t program_emit(Program* program, Instruction instruction) {
+    if (program->size >= program->capacity) {
+        size_t capacity = program->capacity * 2;
+        Instruction* grown = (Instruction*)arena_realloc(program->arena, program->code,
+                                                         program->capacity * sizeof(Instruction),
+                                                         capacity * sizeof(Instruction));
+        if (!grown) return PROGRAM_EMIT_FAILED;
+        program->code = grown;
+        program->capacity = capacity;
+    }
+    program->code[program->size] = instruction;
+    return program->size++;
+}
+
+void program_free(Program* program) {
+    arena_release(program->arena, program->code);
+    program->code = NULL;
+    program->size = 0;
+    program->capacity = 0;
+}
+
+int program_execute_loops(const Program* program, NoteList* list, LoopList* loops) {
+    SynthState state;
+    state.wave = WAVE_SQUARE;
+    state.envelope = (Envelope){ 0.01f, 0.0f, 1.0f, 0.01f };
+    state.slide = 0.0f;
+    state.last_freq = 0.0f;
+
+    float current_time = 0.0f;
+    int depth = 0;
+    LoopFrame* stack = NULL;
+
+    if (program->max_depth > 0) {
+        stack = (LoopFrame*)arena_alloc(program->arena, program->max_depth * sizeof(LoopFrame));
+        if (!stack) return -1;
+    }
+
+    size_t pc = 0;
+    while (pc < program->size) {
+        const Instruction* ins = &program->code[pc];
+
+        switch (ins->op) {
+            case OP_WAVE:
+                state.wave = ins->arg.wave;
+                break;
+
+            case OP_ENVELOPE:
+                state.envelope = ins->arg.envelope;
+                break;
+
+            case OP_SLIDE:
+                state.slide = ins->arg.seconds;
+                break;
+
+            case OP_PAUSE:
+                if (ins->arg.seconds > 0) current_time += ins->arg.seconds;
+                state.last_freq = 0.0f;
+                break;
+
+            case OP_NOTE: {
+                NoteEvent note;
+                note.freq = ins->arg.note.freq;
+                note.duration = ins->arg.note.duration;
+                note.start_time = current_time;
+                note.state = state;
+
+                if (note_list_push(list, note) != 0) {
+                    arena_release(program->arena, stack);
+                    return -1;
+                }
+
+                state.last_freq = note.freq;
+                current_time += note.duration;
+                break;
+            }
+
+            case OP_LOOP:
+                if (ins->arg.loop.count <= 0) {
+                    pc = ins->arg.loop.match;   // Skip body and its OP_END_LOOP
+                    break;
+                }
+                stack[depth].body = pc + 1;
+                stack[depth].remaining = ins->arg.loop.count - 1;
+                stack[depth].first_note = list->size;
+                depth++;
+                break;
+
+            case OP_END_LOOP:
+                if (stack[depth - 1].remaining > 0) {
+                    stack[depth - 1].remaining--;
+                    pc = stack[depth - 1].body;
+                    continue;
+                }
+                depth--;
+                if (loops && list->size > stack[depth].first_note) {
+                    LoopSpan span;
+                    span.first_note = stack[depth].first_note;
+                    span.iterations = ins->arg.loop.count;
+                    span.note_count = (list->size - span.first_note) / span.iterations;
+                    if (loop_list_add(loops, span) != 0) {
+                        arena_release(program->arena, stack);
+                        return -1;
+                    }
+                }
+                break;
+        }
+        pc++;
+    }
+
+    arena_release(program->arena, stack);
+    return 0;
+}
+
+int program_execute(const Program* program, NoteList* list) {
+    return program_execute_loops(program, list, NULL);
+}
@@ -0,0 +1,235 @@
+/**
+ * @file lexer.c
+ * @brief Line tokenizer working directly on the source bytes
+ * @author joaomrpimentel
+ * @version 1.1
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "lexer.h"
+
+/** Longest numeric literal handed to strtod/strtol */
+#define LEXER_NUMBER_MAX 64
+
+/** Significant digits that fit a uint64_t mantissa */
+#define FAST_FLOAT_DIGITS 19
+
+/** Largest power of ten that is exact in a double */
+#define FAST_FLOAT_EXP 22
+
+/**
+ * @brief Keyword slot of the perfect hash
+ */
+typedef struct {
+    const char* text;
+    size_t length;
+    int value;
+} Keyword;
+
+/**
+ * Commands hashed by (length * 5 + first byte) & 7. The function was
+ * chosen so the six keywords land in distinct slots; a token is only
+ * compared against the one keyword sharing its slot.
+ */
+static const Keyword command_table[8] = {
+    { "LOOP",     4, TOKEN_LOOP },
+    { "PAUSE",    5, TOKEN_PAUSE },
+    { "}",        1, TOKEN_CLOSE },
+    { "WAVE",     4, TOKEN_WAVE },
+    { "SLIDE",    5, TOKEN_SLIDE },
+    { "ENVELOPE", 8, TOKEN_ENVELOPE },
+    { NULL,       0, TOKEN_WORD },
+    { NULL,       0, TOKEN_WORD }
+};
+
+/** Waveforms hashed by (length + second byte) & 7 */
+static const Keyword wave_table[8] = {
+    { NULL,       0, 0 },
+    { "SAWTOOTH", 8, WAVE_SAWTOOTH },
+    { "TRIANGLE", 8, WAVE_TRIANGLE },
+    { NULL,       0, 0 },
+    { NULL,       0, 0 },
+    { "SINE",     4, WAVE_SINE },
+    { NULL,       0, 0 },
+    { "SQUARE",   6, WAVE_SQUARE }
+};
+
+/** Exact powers of ten for the fast float path */
+static const double pow10_table[FAST_FLOAT_EXP + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static bool keyword_matches(const Keyword* keyword, const char* src, Token token) {
+    return keyword->length == token.length &&
+           memcmp(src + token.offset, keyword->text, token.length) == 0;
+}
+
+void lexer_init(Lexer* lexer, const char* src, size_t size) {
+    lexer->src = src;
+    lexer->size = size;
+    lexer->pos = 0;
+    lexer->line = 1;
+}
+
+int lexer_next_line(Lexer* lexer, Token* tokens, int* line) {
+    const char* src = lexer->src;
+
+    while (lexer->pos < lexer->size) {
+        size_t start = lexer->pos;
+        const char* newline = (const char*)memchr(src + start, '\n', lexer->size - start);
+        size_t end = newline ? (size_t)(newline - src) : lexer->size;
+
+        *line = lexer->line;
+        lexer->pos = newline ? end + 1 : end;
+        if (newline) lexer->line++;
+
+        // Content stops at the first carriage return
+        const char* cr = (const char*)memchr(src + start, '\r', end - start);
+        if (cr) end = (size_t)(cr - src);
+
+        size_t p = start;
+        while (p < end && (src[p] == ' ' || src[p] == '\t')) p++;
+        if (p == end || src[p] == '#') continue;
+
+        int count = 0;
+        while (p < end && count < LEXER_MAX_TOKENS) {
+            size_t token_start = p;
+            while (p < end && src[p] != ' ' && src[p] != '\t') p++;
+            tokens[count].offset = token_start;
+            tokens[count].length = p - token_start;
+            count++;
+            while (p < end && (src[p] == ' ' || src[p] == '\t')) p++;
+        }
+        return count;
+    }
+    return 0;
+}
+
+bool token_equals(const char* src, Token token, const char* word) {
+    size_t length = strlen(word);
+    return token.length == length && memcmp(src + token.offset, word, length) == 0;
+}
+
+TokenKind token_keyword(const char* src, Token token) {
+    if (token.length == 0 || token.length > 8) return TOKEN_WORD;
+
+    const unsigned char* p = (const unsigned char*)src + token.offset;
+    const Keyword* keyword = &command_table[(token.length * 5 + p[0]) & 7];
+    return keyword_matches(keyword, src, token) ? (TokenKind)keyword->value : TOKEN_WORD;
+}
+
+bool token_wave(const char* src, Token token, WaveType* wave) {
+    if (token.length < 2 || token.length > 8) return false;
+
+    const unsigned char* p = (const unsigned char*)src + token.offset;
+    const Keyword* keyword = &wave_table[(token.length + p[1]) & 7];
+    if (!keyword_matches(keyword, src, token)) return false;
+    *wave = (WaveType)keyword->value;
+    return true;
+}
+
+/**
+ * @brief Converts a plain decimal literal exactly (Clinger's fast path)
+ * @param p Literal bytes
+ * @param length Literal length
+ * @param value Output value, correctly rounded to double
+ * @return true if the whole literal was handled
+ *
+ * With a mantissa below 2^53 and a power of ten that is exact in double
+ * precision, a single multiply or divide is correctly rounded, so the
+ * result equals strtod's.
+ */
+static bool parse_decimal(const char* p, size_t length, double* value) {
+    size_t i = 0;
+    bool negative = false;
+    if (i < length && (p[i] == '+' || p[i] == '-')) negative = p[i++] == '-';
+
+    uint64_t mantissa = 0;
+    int digits = 0;         // Significant digits in the mantissa
+    int scale = 0;          // Decimal exponent applied to the mantissa
+    bool any_digit = false;
+
+    for (; i < length && (unsigned)(p[i] - '0') <= 9; i++) {
+        any_digit = true;
+        if (mantissa == 0 && p[i] == '0') continue;
+        if (++digits > FAST_FLOAT_DIGITS) return false;
+        mantissa = mantissa * 10 + (uint64_t)(p[i] - '0');
+    }
+    if (i < length && p[i] == '.') {
+        for (i++; i < length && (unsigned)(p[i] - '0') <= 9; i++) {
+            any_digit = true;
+            scale--;
+            if (mantissa == 0 && p[i] == '0') continue;
+            if (++digits > FAST_FLOAT_DIGITS) return false;
+            mantissa = mantissa * 10 + (uint64_t)(p[i] - '0');
+        }
+    }
+    if (!any_digit) return false;
+
+    if (i < length && (p[i] == 'e' || p[i] == 'E')) {
+        size_t e = i + 1;
+        bool exp_negative = false;
+        if (e < length && (p[e] == '+' || p[e] == '-')) exp_negative = p[e++] == '-';
+        if (e == length) return false;
+        int exponent = 0;
+        for (; e < length && (unsigned)(p[e] - '0') <= 9; e++) {
+            if (exponent > 1000) return false;
+            exponent = exponent * 10 + (p[e] - '0');
+        }
+        scale += exp_negative ? -exponent : exponent;
+        i = e;
+    }
+    if (i != length) return false;
+
+    if (mantissa == 0) {
+        *value = negative ? -0.0 : 0.0;
+        return true;
+    }
+    if (mantissa >> 53) return false;
+    if (scale < -FAST_FLOAT_EXP || scale > FAST_FLOAT_EXP) return false;
+
+    double result = (double)mantissa;
+    result = scale < 0 ? result / pow10_table[-scale] : result * pow10_table[scale];
+    *value = negative ? -result : result;
+    return true;
+}
+
+/**
+ * @brief Copies a token into a NUL-terminated buffer for the C library parsers
+ *
+ * Numeric literals are short; a longer token only loses digits far
+ * beyond float precision.
+ */
+static void token_copy(const char* src, Token token, char* buffer) {
+    size_t length = token.length < LEXER_NUMBER_MAX - 1 ? token.length : LEXER_NUMBER_MAX - 1;
+    memcpy(buffer, src + token.offset, length);
+    buffer[length] = '\0';
+}
+
+float token_to_float(const char* src, Token token) {
+    double value;
+    if (parse_decimal(src + token.offset, token.length, &value)) return (float)value;
+
+    char buffer[LEXER_NUMBER_MAX];
+    token_copy(src, token, buffer);
+    return (float)strtod(buffer, NULL);
+}
+
+int token_to_int(const char* src, Token token) {
+    // Plain counts of up to nine digits cannot overflow an int
+    const char* p = src + token.offset;
+    size_t i = token.length > 0 && (p[0] == '+' || p[0] == '-') ? 1 : 0;
+    if (token.length > i && token.length - i <= 9) {
+        int value = 0;
+        size_t d = i;
+        while (d < token.length && (unsigned)(p[d] - '0') <= 9) value = value * 10 + (p[d++] - '0');
+        if (d == token.length) return p[0] == '-' ? -value : value;
+    }
+
+    char buffer[LEXER_NUMBER_MAX];
+    token_copy(src, token, buffer);
+    return (int)strtol(buffer, NULL, 10);
+}
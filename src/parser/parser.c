@@ -2,185 +2,197 @@
  * @file parser.c
  * @brief JSHL language parser implementation
  * @author joaomrpimentel
- * @version 1.0
+ * @version 1.6
  */
 
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 #include "parser.h"
 #include "note_table.h"
+#include "lexer.h"
 
 /**
- * @brief Recursive parser for JSHL language constructs
- * @param lines Array of source code lines
- * @param line_count Total number of lines in array
- * @param current_line Pointer to current line index (modified during parsing)
- * @param start_time Starting time offset in seconds
- * @param state Current synthesizer state (modified by commands)
- * @param list Note list to populate with parsed events
- * @return Final time position after parsing block
+ * @brief Resolves a note token to its frequency
+ * @param src Source bytes
+ * @param token Note name token
+ * @return Frequency in Hz, or 0.0 if the name is unknown
+ */
+static float token_note_freq(const char* src, Token token) {
+    int midi = note_name_to_midi(src + token.offset, token.length);
+    return midi < 0 ? 0.0f : note_freq_table[midi];
+}
+
+/**
+ * @brief Records a diagnostic and hands it to program->report if set
+ * @param program Program being compiled
+ * @param line Source line of the problem
+ * @param format printf-style message, including its "Warning:" prefix
+ */
+static void parser_warning(Program* program, int line, const char* format, ...) {
+    if (program->warnings++ == 0) program->first_warning_line = line;
+    if (!program->report) return;
+
+    va_list args;
+    va_start(args, format);
+    program->report(format, args);
+    va_end(args);
+}
+
+/**
+ * @brief Single-pass compiler from source bytes to IR
+ * @param src Source bytes (need not be NUL-terminated)
+ * @param size Source length
+ * @param program Output program
+ * @return 0 on success, -1 on allocation failure
  * 
  * Handles JSHL commands:
  * - WAVE <type>: Sets waveform (SINE, SQUARE, SAWTOOTH, TRIANGLE)
  * - ENVELOPE <A> <D> <S> <R>: Configures ADSR envelope
  * - SLIDE <duration>: Sets portamento time
  * - PAUSE <duration>: Adds silence
- * - LOOP <count> { ... }: Repeats enclosed block
- * - <note> <duration>: Adds note event
+ * - LOOP <count> { ... }: Repeats enclosed block (blocks may nest)
+ * - <note> <duration>: Adds note event (frequency resolved here, once)
  * 
- * @note Uses local buffer to preserve line data across loop iterations
+ * @note Every line is read exactly once, however many times a loop repeats
  */
-static float parse_jshl_recursive(char** lines, int line_count, int* current_line, 
-                                  float start_time, SynthState* state, NoteList* list) {
-    
-    float current_time = start_time;
-    int i = *current_line;
-
-    while (i < line_count) {
-        *current_line = i;
-        
-        char line_buffer[256];
-        strncpy(line_buffer, lines[i], sizeof(line_buffer) - 1);
-        line_buffer[sizeof(line_buffer) - 1] = '\0';
-        char* line = line_buffer;
-        
-        i++;
-
-        while (*line == ' ' || *line == '\t') line++;
-        line[strcspn(line, "\r\n")] = 0;
-        
-        if (line[0] == '\0' || line[0] == '#') continue;
-
-        char* saveptr;
-        char* command = strtok_r(line, " \t", &saveptr);
-        if (!command) continue;
-
-        if (strcmp(command, "WAVE") == 0) {
-            char* type = strtok_r(NULL, " \t", &saveptr);
-            if (!type) continue;
-            if (strcmp(type, "SINE") == 0) state->wave = WAVE_SINE;
-            else if (strcmp(type, "SQUARE") == 0) state->wave = WAVE_SQUARE;
-            else if (strcmp(type, "SAWTOOTH") == 0) state->wave = WAVE_SAWTOOTH;
-            else if (strcmp(type, "TRIANGLE") == 0) state->wave = WAVE_TRIANGLE;
-        } 
-        else if (strcmp(command, "ENVELOPE") == 0) {
-            char* tok;
-            tok = strtok_r(NULL, " \t", &saveptr);
-            state->envelope.attack = tok ? atof(tok) : 0.01f;
-            tok = strtok_r(NULL, " \t", &saveptr);
-            state->envelope.decay = tok ? atof(tok) : 0.0f;
-            tok = strtok_r(NULL, " \t", &saveptr);
-            state->envelope.sustain = tok ? atof(tok) : 1.0f;
-            tok = strtok_r(NULL, " \t", &saveptr);
-            state->envelope.release = tok ? atof(tok) : 0.01f;
-        }
-        else if (strcmp(command, "SLIDE") == 0) {
-            char* tok = strtok_r(NULL, " \t", &saveptr);
-            state->slide = tok ? atof(tok) : 0.0f;
-        }
-        else if (strcmp(command, "PAUSE") == 0) {
-            char* tok = strtok_r(NULL, " \t", &saveptr);
-            float duration = tok ? atof(tok) : 0.0f;
-            if (duration > 0) current_time += duration;
-            state->last_freq = 0.0f;
-        }
-        else if (strcmp(command, "LOOP") == 0) {
-            char* tok = strtok_r(NULL, " \t", &saveptr);
-            int loop_count = tok ? atoi(tok) : 1;
-            
-            int loop_start_line = i;
-            int loop_end_line = -1;
-            int j;
-            for (j = i; j < line_count; j++) {
-                if (strstr(lines[j], "}")) {
-                    loop_end_line = j;
+static int compile_source(const char* src, size_t size, Program* program) {
+    size_t* open_loops = NULL;
+    int status = 0;
+    int depth = 0;
+    int open_capacity = 0;
+
+    Lexer lexer;
+    Token tokens[LEXER_MAX_TOKENS];
+    int line_number;
+    int count;
+    lexer_init(&lexer, src, size);
+
+    while (status == 0 && (count = lexer_next_line(&lexer, tokens, &line_number)) > 0) {
+        Token command = tokens[0];
+        Instruction ins;
+        ins.line = line_number;
+
+        switch (token_keyword(src, command)) {
+        case TOKEN_WAVE:
+            if (count < 2 || !token_wave(src, tokens[1], &ins.arg.wave)) continue;
+            ins.op = OP_WAVE;
+            if (program_emit(program, ins) == PROGRAM_EMIT_FAILED) status = -1;
+            break;
+
+        case TOKEN_ENVELOPE:
+            ins.op = OP_ENVELOPE;
+            ins.arg.envelope.attack = count > 1 ? token_to_float(src, tokens[1]) : 0.01f;
+            ins.arg.envelope.decay = count > 2 ? token_to_float(src, tokens[2]) : 0.0f;
+            ins.arg.envelope.sustain = count > 3 ? token_to_float(src, tokens[3]) : 1.0f;
+            ins.arg.envelope.release = count > 4 ? token_to_float(src, tokens[4]) : 0.01f;
+            if (program_emit(program, ins) == PROGRAM_EMIT_FAILED) status = -1;
+            break;
+
+        case TOKEN_SLIDE:
+            ins.op = OP_SLIDE;
+            ins.arg.seconds = count > 1 ? token_to_float(src, tokens[1]) : 0.0f;
+            if (program_emit(program, ins) == PROGRAM_EMIT_FAILED) status = -1;
+            break;
+
+        case TOKEN_PAUSE:
+            ins.op = OP_PAUSE;
+            ins.arg.seconds = count > 1 ? token_to_float(src, tokens[1]) : 0.0f;
+            if (program_emit(program, ins) == PROGRAM_EMIT_FAILED) status = -1;
+            break;
+
+        case TOKEN_LOOP: {
+            ins.op = OP_LOOP;
+            ins.arg.loop.count = count > 1 ? token_to_int(src, tokens[1]) : 1;
+            ins.arg.loop.match = 0;
+
+            if (depth == open_capacity) {
+                int capacity = open_capacity ? open_capacity * 2 : 8;
+                size_t* grown = (size_t*)arena_realloc(program->arena, open_loops,
+                                                       open_capacity * sizeof(size_t),
+                                                       capacity * sizeof(size_t));
+                if (!grown) {
+                    status = -1;
                     break;
                 }
+                open_loops = grown;
+                open_capacity = capacity;
             }
-
-            if (loop_end_line != -1) {
-                for (int k = 0; k < loop_count; k++) {
-                    int temp_line = loop_start_line;
-                    current_time = parse_jshl_recursive(lines, loop_end_line, &temp_line,
-                                                        current_time, state, list);
-                }
-                i = loop_end_line + 1;
-            } else {
-                fprintf(stderr, "Syntax error: Unclosed LOOP at line %d\n", i);
+            size_t index = program_emit(program, ins);
+            if (index == PROGRAM_EMIT_FAILED) {
+                status = -1;
+                break;
             }
+            open_loops[depth++] = index;
+            if (depth > program->max_depth) program->max_depth = depth;
+            break;
         }
-        else if (strcmp(command, "}") == 0) {
-            return current_time;
-        }
-        else {
-            float freq = get_note_freq(command);
-            char* tok = strtok_r(NULL, " \t", &saveptr);
-            float duration = tok ? atof(tok) : 0.0f;
 
-            if (freq > 0 && duration > 0) {
-                NoteEvent note;
-                note.freq = freq;
-                note.duration = duration;
-                note.start_time = current_time;
-                note.state = *state;
+        case TOKEN_CLOSE: {
+            if (depth == 0) {
+                parser_warning(program, line_number, "Warning: Unmatched '}' at line %d\n",
+                               line_number);
+                continue;
+            }
+            size_t loop = open_loops[--depth];
+            ins.op = OP_END_LOOP;
+            ins.arg.loop.count = program->code[loop].arg.loop.count;
+            ins.arg.loop.match = loop;
+            size_t index = program_emit(program, ins);
+            if (index == PROGRAM_EMIT_FAILED) {
+                status = -1;
+                break;
+            }
+            program->code[loop].arg.loop.match = index;
+            break;
+        }
 
-                note_list_add(list, note);
+        case TOKEN_WORD: {
+            float freq = token_note_freq(src, command);
+            float duration = count > 1 ? token_to_float(src, tokens[1]) : 0.0f;
 
-                state->last_freq = freq;
-                current_time += duration;
+            if (freq > 0 && duration > 0) {
+                ins.op = OP_NOTE;
+                ins.arg.note.freq = freq;
+                ins.arg.note.duration = duration;
+                if (program_emit(program, ins) == PROGRAM_EMIT_FAILED) status = -1;
             } else if (freq == 0.0f && duration > 0.0f) {
-                fprintf(stderr, "Warning: Unknown note '%s' at line %d\n", command, i);
+                parser_warning(program, line_number, "Warning: Unknown note '%.*s' at line %d\n",
+                               (int)command.length, src + command.offset, line_number);
             }
+            break;
+        }
         }
     }
-    *current_line = i;
-    return current_time;
-}
 
-void parse_jshl(char* code, NoteList* list) {
-    char* code_copy = strdup(code);
-    if (!code_copy) {
-        fprintf(stderr, "Error: Memory allocation failed\n");
-        exit(1);
-    }
-    
-    int line_count = 1;
-    char* p = code_copy;
-    while ((p = strchr(p, '\n'))) {
-        line_count++;
-        p++;
-    }
+    // Unclosed blocks are reported and played once
+    while (status == 0 && depth > 0) {
+        size_t loop = open_loops[--depth];
+        parser_warning(program, program->code[loop].line,
+                       "Syntax error: Unclosed LOOP at line %d\n", program->code[loop].line);
 
-    char** lines = (char**)malloc(line_count * sizeof(char*));
-    if (!lines) {
-        fprintf(stderr, "Error: Memory allocation failed\n");
-        free(code_copy);
-        exit(1);
-    }
-    
-    int i = 0;
-    p = code_copy;
-    char* line_start = p;
-    while (*p) {
-        if (*p == '\n') {
-            *p = '\0';
-            lines[i++] = line_start;
-            line_start = p + 1;
+        Instruction ins;
+        ins.op = OP_END_LOOP;
+        ins.line = lexer.line;
+        ins.arg.loop.count = 1;
+        ins.arg.loop.match = loop;
+        program->code[loop].arg.loop.count = 1;
+        size_t index = program_emit(program, ins);
+        if (index == PROGRAM_EMIT_FAILED) {
+            status = -1;
+            break;
         }
-        p++;
+        program->code[loop].arg.loop.match = index;
     }
-    lines[i] = line_start;
-
-    SynthState state;
-    state.wave = WAVE_SQUARE;
-    state.envelope = (Envelope){ 0.01f, 0.0f, 1.0f, 0.01f };
-    state.slide = 0.0f;
-    state.last_freq = 0.0f;
-
-    int current_line = 0;
-    parse_jshl_recursive(lines, line_count, &current_line, 0.0f, &state, list);
-    
-    free(code_copy);
-    free(lines);
-}
\ No newline at end of file
+
+    arena_release(program->arena, open_loops);
+    return status;
+}
+
+int parse_jshl_source(const char* src, size_t size, Program* program) {
+    return compile_source(src, size, program);
+}
+
+int parse_jshl_program(char* code, Program* program) {
+    return parse_jshl_source(code, strlen(code), program);
+}